@@ -0,0 +1,91 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "World.h"
+#include "JobSystem.h"
+
+using namespace mcplus;
+
+static constexpr int TICKS = 100;
+
+static void populate(World& world, std::size_t arrowCount, std::size_t itemCount) {
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> coordinate{0, 1024};
+    std::uniform_int_distribution<int> direction{1, 4};
+
+    WorldId level = world.getId();
+    for (std::size_t i = 0; i < arrowCount; i++) {
+        world.addEntity(std::make_shared<ArrowEntity>(Location2f{level, coordinate(random), coordinate(random)}, nullptr,
+                                                      static_cast<Direction>(direction(random)), 1));
+    }
+    for (std::size_t i = 0; i < itemCount; i++) {
+        // long lived so the population stays the same for the whole run
+        world.addEntity(std::make_shared<ItemEntity>(Location2f{level, coordinate(random), coordinate(random)},
+                                                     std::make_shared<Item>(), TICKS * 2));
+    }
+}
+
+static void bench(std::size_t arrowCount, std::size_t itemCount) {
+    World world{0, "bench"};
+    populate(world, arrowCount, itemCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS; tick++) {
+        world.tick();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::setw(8) << arrowCount << " arrows" << std::setw(8) << itemCount << " items"
+              << std::fixed << std::setprecision(3)
+              << std::setw(10) << elapsed.count() / TICKS << " ms/tick" << std::endl;
+}
+
+// every level with the same population, ticked one after the other and then as jobs
+static void benchLevels(int levelCount, std::size_t entityCount, JobSystem& jobs) {
+    std::vector<std::unique_ptr<World>> worlds{};
+    for (int level = 0; level < levelCount; level++) {
+        worlds.push_back(std::make_unique<World>(static_cast<WorldId>(-level), "bench"));
+        populate(*worlds.back(), entityCount / 2, entityCount / 2);
+    }
+
+    std::vector<JobSystem::Job> tasks{};
+    for (auto& world : worlds) {
+        tasks.emplace_back([&world, &jobs]() {
+            world->tick(&jobs);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS / 2; tick++) {
+        for (auto& world : worlds) {
+            world->tick();
+        }
+    }
+    std::chrono::duration<double, std::milli> serial = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS / 2; tick++) {
+        jobs.run(tasks);
+    }
+    std::chrono::duration<double, std::milli> parallel = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::setw(8) << levelCount << " levels" << std::setw(8) << entityCount << " each "
+              << std::fixed << std::setprecision(3)
+              << std::setw(10) << serial.count() / (TICKS / 2) << " ms/tick serial"
+              << std::setw(10) << parallel.count() / (TICKS / 2) << " ms/tick on " << jobs.size() + 1 << " threads" << std::endl;
+}
+
+int main() {
+    bench(10000, 10000);
+    bench(50000, 50000);
+
+    JobSystem jobs{};
+    benchLevels(1, 20000, jobs);
+    benchLevels(6, 20000, jobs);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+
+#include "Socket.h"
+#include "Protocol.h"
+#include "FrameReader.h"
+
+using namespace mcplus;
+
+static constexpr std::size_t PACKET_COUNT = 200000;
+
+// a mix of what clients usually send: lots of moves, some pings and interactions
+static std::string buildStream(std::size_t& packetCount) {
+    std::string stream{};
+    const std::string payloads[] = {"2051;1187;1;0", "2052;1187;1;0", "auto", "Wood Pickaxe;8;0", "2052;1188;2;0"};
+
+    for (packetCount = 0; packetCount < PACKET_COUNT; packetCount++) {
+        const auto& payload = payloads[packetCount % 5];
+        stream += static_cast<char>(packetCount % 5 == 2 ? PacketType::PING : PacketType::MOVE);
+        stream += payload;
+        stream += '\0';
+    }
+
+    return stream;
+}
+
+template<typename Reader>
+static void run(const char* name, const std::string& stream, std::size_t packetCount, Reader reader) {
+    int pair[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+
+    std::thread writer{[&stream, fd = pair[0]]() {
+        std::size_t sent = 0;
+        while (sent < stream.size()) {
+            ssize_t result = send(fd, stream.data() + sent, stream.size() - sent, 0);
+            if (result <= 0) {
+                break;
+            }
+            sent += result;
+        }
+    }};
+
+    utils::Socket socket{pair[1]};
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t syscalls = reader(socket, packetCount);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    writer.join();
+    ::shutdown(pair[0], SHUT_RDWR);
+
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << static_cast<double>(syscalls) / packetCount << " syscalls/packet"
+              << std::setw(12) << (stream.size() / elapsed.count()) / (1024 * 1024) << " MB/s"
+              << std::setw(12) << packetCount / elapsed.count() / 1000 << " kpackets/s" << std::endl;
+}
+
+int main() {
+    std::size_t packetCount = 0;
+    std::string stream = buildStream(packetCount);
+
+    std::cout << packetCount << " packets, " << stream.size() << " bytes" << std::endl;
+
+    run("readPacket", stream, packetCount, [](utils::Socket& socket, std::size_t count) {
+        std::uint64_t syscalls = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            RawPacket rawPacket = readPacket(socket);
+            // one recv for the id, one per payload byte and one for the terminator
+            syscalls += rawPacket.data.size() + 2;
+        }
+        return syscalls;
+    });
+
+    run("FrameReader", stream, packetCount, [](utils::Socket& socket, std::size_t count) {
+        FrameReader reader{};
+        RawPacket rawPacket{};
+        for (std::size_t i = 0; i < count; i++) {
+            while (!reader.next(rawPacket)) {
+                reader.fill(socket);
+            }
+        }
+        return reader.getSyscalls();
+    });
+
+    return 0;
+}
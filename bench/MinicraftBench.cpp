@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include "Socket.h"
+#include "Protocol.h"
+#include "Packet.h"
+#include "FrameReader.h"
+#include "Utils.h"
+
+using namespace mcplus;
+
+using Clock = std::chrono::steady_clock;
+
+// the server sends whole levels, far bigger than what clients may send it
+static constexpr std::size_t SERVER_FRAME_CAPACITY = 16 * 1024 * 1024;
+
+/**
+ * Headless load generator: N clients LOGIN and LOAD against a running
+ * server, then stream MOVE, INTERACT and PING at fixed rates. The server
+ * echoes every PING, which gives the round trip through a whole tick.
+ *
+ *   MinicraftBench [--host 127.0.0.1] [--port 4225] [--clients 100] [--seconds 10]
+ *                  [--threads 4] [--move-rate 20] [--interact-rate 1] [--ping-rate 1]
+ *
+ * Rates are packets per second per client, 0 turns a packet off.
+ */
+struct Options {
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 4225;
+    std::size_t clients = 100;
+    std::size_t threads = 4;
+    double seconds = 10;
+    double moveRate = 20;
+    double interactRate = 1;
+    double pingRate = 1;
+};
+
+struct Stream {
+    double rate;
+    Clock::duration period;
+    Clock::time_point next;
+};
+
+struct Client {
+    std::size_t index;
+    std::shared_ptr<utils::Socket> socket;
+    FrameReader reader;
+    bool loaded;
+    bool closed;
+    Clock::time_point connectedAt;
+
+    Stream move;
+    Stream interact;
+    Stream ping;
+    // sent times of the pings not echoed yet, the server answers in order
+    std::deque<Clock::time_point> pings;
+    int step;
+};
+
+struct Totals {
+    std::size_t connected = 0;
+    std::size_t loaded = 0;
+    std::size_t dropped = 0;
+
+    std::uint64_t moves = 0;
+    std::uint64_t interacts = 0;
+    std::uint64_t pings = 0;
+    std::uint64_t received = 0;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t bytesReceived = 0;
+
+    std::uint64_t writeCalls = 0;
+    std::uint64_t readCalls = 0;
+    std::uint64_t pollCalls = 0;
+
+    std::vector<double> logins; // ms
+    std::vector<double> rtts;   // ms
+
+    void merge(const Totals& totals) {
+        connected += totals.connected;
+        loaded    += totals.loaded;
+        dropped   += totals.dropped;
+
+        moves     += totals.moves;
+        interacts += totals.interacts;
+        pings     += totals.pings;
+        received  += totals.received;
+        bytesSent     += totals.bytesSent;
+        bytesReceived += totals.bytesReceived;
+
+        writeCalls += totals.writeCalls;
+        readCalls  += totals.readCalls;
+        pollCalls  += totals.pollCalls;
+
+        logins.insert(logins.end(), totals.logins.begin(), totals.logins.end());
+        rtts.insert(rtts.end(), totals.rtts.begin(), totals.rtts.end());
+    }
+};
+
+static double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static Stream makeStream(double rate) {
+    Stream stream{rate, Clock::duration::zero(), Clock::time_point::max()};
+    if (rate > 0) {
+        stream.period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    }
+    return stream;
+}
+
+static void send(Client& client, const Packet& packet, Totals& totals) {
+    auto rawPacket = static_cast<RawPacket>(packet);
+    totals.bytesSent += rawPacket.data.size() + 2;
+    queuePacket(*client.socket, std::move(rawPacket));
+}
+
+// clients start their streams spread over one period, not all at once
+static void start(Client& client, std::size_t clientCount, Clock::time_point now) {
+    double phase = static_cast<double>(client.index) / static_cast<double>(clientCount);
+
+    for (Stream* stream : {&client.move, &client.interact, &client.ping}) {
+        if (stream->rate > 0) {
+            stream->next = now + std::chrono::duration_cast<Clock::duration>(stream->period * phase);
+        }
+    }
+}
+
+static void sendDue(Client& client, Clock::time_point now, Totals& totals) {
+    while (client.move.next <= now) {
+        client.step++;
+        // walks back and forth along a short line around the spawn
+        int offset = client.step % 32 < 16 ? client.step % 16 : 16 - client.step % 16;
+        send(client, MovePacket{FixedLocation{static_cast<int32_t>(256 + offset), 0, static_cast<int32_t>(256 + client.index % 64), 0},
+                                Direction::RIGHT, 0}, totals);
+        client.move.next += client.move.period;
+        totals.moves++;
+    }
+    while (client.interact.next <= now) {
+        send(client, InteractPacket{Item{ItemMaterial::POWER_GLOVE}}, totals);
+        client.interact.next += client.interact.period;
+        totals.interacts++;
+    }
+    while (client.ping.next <= now) {
+        send(client, PingPacket{PingType::AUTO}, totals);
+        client.pings.push_back(now);
+        client.ping.next += client.ping.period;
+        totals.pings++;
+    }
+}
+
+static void onFrame(Client& client, const RawPacket& rawPacket, std::size_t clientCount, Totals& totals) {
+    auto now = Clock::now();
+    totals.received++;
+
+    switch (static_cast<PacketType>(rawPacket.id)) {
+        case PacketType::GAME:
+            // the last answer to LOAD, the client is in the world
+            if (!client.loaded) {
+                client.loaded = true;
+                totals.loaded++;
+                totals.logins.push_back(milliseconds(now - client.connectedAt));
+                start(client, clientCount, now);
+            }
+            break;
+        case PacketType::PING:
+            if (!client.pings.empty()) {
+                totals.rtts.push_back(milliseconds(now - client.pings.front()));
+                client.pings.pop_front();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void drive(const Options& options, std::vector<Client>& clients, Totals& totals, Clock::time_point deadline) {
+    for (auto& client : clients) {
+        try {
+            client.socket = std::make_shared<utils::Socket>(options.host, options.port);
+        } catch (const std::logic_error& exception) {
+            client.closed = true;
+            totals.dropped++;
+            continue;
+        }
+
+        totals.connected++;
+        client.connectedAt = Clock::now();
+        send(client, LoginPacket{"bench" + std::to_string(client.index), VersionPack{2, 0, 6}}, totals);
+        send(client, LoadPacket{0}, totals);
+        client.socket->flush();
+        client.socket->setBlocking(false);
+    }
+
+    std::vector<pollfd> descriptors{};
+    std::vector<Client*> polled{};
+    RawPacket rawPacket{};
+
+    while (true) {
+        auto now = Clock::now();
+        if (now >= deadline) {
+            break;
+        }
+
+        auto wake = deadline;
+        descriptors.clear();
+        polled.clear();
+        for (auto& client : clients) {
+            if (client.closed) {
+                continue;
+            }
+
+            if (client.loaded) {
+                sendDue(client, now, totals);
+                wake = std::min({wake, client.move.next, client.interact.next, client.ping.next});
+            }
+
+            short events = POLLIN;
+            try {
+                if (!client.socket->flush()) {
+                    events |= POLLOUT;
+                }
+            } catch (const std::logic_error& exception) {
+                client.closed = true;
+                totals.dropped++;
+                continue;
+            }
+
+            descriptors.push_back(pollfd{.fd = client.socket->getDescriptor(), .events = events, .revents = 0});
+            polled.push_back(&client);
+        }
+
+        if (descriptors.empty()) {
+            break;
+        }
+
+        // rounded up, a timeout of 0 would spin until the next packet is due
+        auto timeout = std::chrono::ceil<std::chrono::milliseconds>(wake - Clock::now()).count();
+        totals.pollCalls++;
+        if (poll(descriptors.data(), descriptors.size(), static_cast<int>(std::max<decltype(timeout)>(timeout, 0))) <= 0) {
+            continue;
+        }
+
+        for (std::size_t i = 0; i < descriptors.size(); i++) {
+            if ((descriptors[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+
+            Client& client = *polled[i];
+            try {
+                while (client.reader.fill(*client.socket) > 0) {
+                    while (client.reader.next(rawPacket)) {
+                        onFrame(client, rawPacket, options.clients, totals);
+                    }
+                }
+            } catch (const std::exception& exception) {
+                client.closed = true;
+                totals.dropped++;
+            }
+        }
+    }
+
+    for (auto& client : clients) {
+        if (!client.socket) {
+            continue;
+        }
+
+        if (!client.closed) {
+            try {
+                send(client, DisconnectPacket{}, totals);
+                client.socket->setBlocking(true);
+                client.socket->flush();
+            } catch (const std::logic_error& exception) {
+                // already gone, nothing left to say
+            }
+        }
+
+        totals.writeCalls    += client.socket->getWriteCalls();
+        totals.readCalls     += client.reader.getSyscalls();
+        totals.bytesReceived += client.reader.getBytesRead();
+        client.socket->close();
+    }
+}
+
+static double percentile(std::vector<double>& values, double rank) {
+    if (values.empty()) {
+        return 0;
+    }
+
+    auto position = static_cast<std::size_t>(rank * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<long>(position), values.end());
+    return values[position];
+}
+
+static void printLatency(const char* name, std::vector<double>& values) {
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(2)
+              << "p50 " << std::setw(8) << percentile(values, 0.50) << " ms"
+              << "  p90 " << std::setw(8) << percentile(values, 0.90) << " ms"
+              << "  p99 " << std::setw(8) << percentile(values, 0.99) << " ms"
+              << "  max " << std::setw(8) << percentile(values, 1.0) << " ms"
+              << "  (" << values.size() << " samples)" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string name{argv[i]};
+        std::string_view value{argv[i + 1]};
+
+        if (name == "--host") {
+            options.host = value;
+        } else if (name == "--port") {
+            options.port = utils::parseNumber<std::uint16_t>(value);
+        } else if (name == "--clients") {
+            options.clients = utils::parseNumber<std::size_t>(value);
+        } else if (name == "--threads") {
+            options.threads = utils::parseNumber<std::size_t>(value);
+        } else if (name == "--seconds") {
+            options.seconds = utils::parseNumber<double>(value);
+        } else if (name == "--move-rate") {
+            options.moveRate = utils::parseNumber<double>(value);
+        } else if (name == "--interact-rate") {
+            options.interactRate = utils::parseNumber<double>(value);
+        } else if (name == "--ping-rate") {
+            options.pingRate = utils::parseNumber<double>(value);
+        } else {
+            std::cerr << "Unknown option " << name << std::endl;
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << std::endl;
+        return false;
+    }
+
+    options.threads = std::clamp<std::size_t>(options.threads, 1, std::max<std::size_t>(options.clients, 1));
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options{};
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    // every thread drives its own slice of the clients
+    std::vector<std::vector<Client>> slices(options.threads);
+    for (std::size_t i = 0; i < options.clients; i++) {
+        slices[i % options.threads].push_back(Client{i, nullptr, FrameReader{FrameReader::DEFAULT_CAPACITY, SERVER_FRAME_CAPACITY}, false, false, {},
+                                                     makeStream(options.moveRate),
+                                                     makeStream(options.interactRate),
+                                                     makeStream(options.pingRate), {}, 0});
+    }
+
+    std::cout << "Driving " << options.clients << " clients against " << options.host << ':' << options.port
+              << " for " << options.seconds << " s on " << options.threads << " threads" << std::endl;
+
+    auto begin = Clock::now();
+    auto deadline = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+
+    Totals totals{};
+    std::mutex totalsMutex;
+    std::vector<std::thread> threads{};
+    for (auto& slice : slices) {
+        threads.emplace_back([&options, &slice, &totals, &totalsMutex, deadline]() {
+            Totals local{};
+            drive(options, slice, local, deadline);
+
+            std::lock_guard<std::mutex> lock{totalsMutex};
+            totals.merge(local);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::uint64_t sent = totals.moves + totals.interacts + totals.pings;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(12) << "Clients" << std::right
+              << totals.connected << " connected, " << totals.loaded << " loaded, " << totals.dropped << " dropped" << std::endl;
+    printLatency("Login", totals.logins);
+    std::cout << std::left << std::setw(12) << "Sent" << std::right
+              << sent << " packets (" << static_cast<double>(sent) / elapsed << "/s) - "
+              << totals.moves << " MOVE, " << totals.interacts << " INTERACT, " << totals.pings << " PING - "
+              << static_cast<double>(totals.bytesSent) / 1024 << " KiB" << std::endl;
+    std::cout << std::left << std::setw(12) << "Received" << std::right
+              << totals.received << " packets (" << static_cast<double>(totals.received) / elapsed << "/s) - "
+              << static_cast<double>(totals.bytesReceived) / 1024 << " KiB" << std::endl;
+    printLatency("RTT", totals.rtts);
+    std::cout << std::left << std::setw(12) << "Syscalls" << std::right << std::setprecision(2)
+              << totals.writeCalls << " writev, " << totals.readCalls << " readv, " << totals.pollCalls << " poll - "
+              << static_cast<double>(totals.writeCalls + totals.readCalls) / static_cast<double>(std::max<std::uint64_t>(sent, 1))
+              << " per packet sent" << std::endl;
+
+    return totals.dropped == 0 ? 0 : 2;
+}
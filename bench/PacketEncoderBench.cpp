@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Packet.h"
+#include "Utils.h"
+
+using namespace mcplus;
+
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void* pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+template<typename Function>
+static void run(const char* name, std::size_t iterations, Function function) {
+    std::size_t bytes = 0;
+
+    // warm up, so one-time statics don't count
+    bytes += function();
+
+    std::size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        bytes += function();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::size_t allocated = allocations - before;
+
+    std::cout << std::left << std::setw(18) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << elapsed.count() / iterations << " ns/op"
+              << std::setw(8) << static_cast<double>(allocated) / iterations << " allocs/op"
+              << std::setw(10) << bytes / (iterations + 1) << " bytes" << std::endl;
+}
+
+template<typename P>
+static std::size_t encode(const P& packet) {
+    return static_cast<RawPacket>(packet).data.size();
+}
+
+int main() {
+    std::vector<Tile> tiles(128 * 128);
+    for (std::size_t i = 0; i < tiles.size(); i++) {
+        tiles[i] = Tile{static_cast<TileId>(i % 44), static_cast<uint8_t>(i % 7)};
+    }
+
+    // long runs of the same tile, closer to what a generated map looks like
+    std::vector<Tile> terrain(128 * 128);
+    for (std::size_t i = 0; i < terrain.size(); i++) {
+        terrain[i] = Tile{static_cast<TileId>((i / 37) % 3), 0};
+    }
+
+    GamePacket game{"survival", 6000, 1.5f, true, 10, 1, 1};
+    InitPacket init{12, 128, 128, 0, 64, 64};
+    TilesPacket tilesPacket{tiles};
+    PlayerPacket player{VersionPack{}, 1024, 2048, 1024, 2048, 10, 10, 0, 0, ItemMaterial::NULL_MATERIAL, 120, 0,
+                        {Potion{PotionType::SPEED, 30}, Potion{PotionType::LIGHT, 20}}, Color{}, false, {}};
+    MovePacket move{FixedLocation{1024, 3, 2048, 9}, Direction::LEFT, 0};
+    ArrowEntity arrow{Location2f{0, 10.5f, 20.25f}, nullptr, Direction::UP, 3};
+
+    run("GamePacket", 1000000, [&game]() { return encode(game); });
+    run("InitPacket", 1000000, [&init]() { return encode(init); });
+    run("TilesPacket", 200, [&tilesPacket]() { return encode(tilesPacket); });
+    run("BinaryTiles RAW", 200, [&tiles]() { return encode(BinaryTilesPacket{tiles, TileEncoding::RAW}); });
+    run("BinaryTiles RLE", 200, [&terrain]() { return encode(BinaryTilesPacket{terrain, TileEncoding::RLE}); });
+    run("PlayerPacket", 500000, [&player]() { return encode(player); });
+    run("MovePacket", 1000000, [&move]() { return encode(move); });
+    // the payload handed back once sent, as Socket::flush does
+    run("Move + recycle", 1000000, [&move]() {
+        auto rawPacket = static_cast<RawPacket>(move);
+        std::size_t size = rawPacket.data.size();
+        utils::BufferPool::global().release(std::move(rawPacket.data));
+        return size;
+    });
+    run("Entity::raw", 1000000, [&arrow]() { return arrow.raw().size(); });
+
+    // what the interest manager does for every moving entity each tick
+    utils::TextEncoder deltas{4096};
+    float step = 0;
+    run("move + delta", 1000000, [&arrow, &deltas, &step]() {
+        step += 0.25f;
+        arrow.setLocation(Location2f{0, 10.5f + step, 20.25f + step});
+
+        deltas.clear();
+        arrow.writeUpdate(deltas);
+        return deltas.size();
+    });
+
+    auto textTiles   = static_cast<RawPacket>(TilesPacket{terrain});
+    auto binaryTiles = static_cast<RawPacket>(BinaryTilesPacket{terrain});
+    run("decode Tiles", 200, [&textTiles]() { return TilesPacket{textTiles}.tileList.size(); });
+    run("decode Binary", 200, [&binaryTiles]() { return BinaryTilesPacket{binaryTiles}.tileList.size(); });
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "World.h"
+#include "ChunkIO.h"
+
+using namespace mcplus;
+
+// 4096x4096 tiles, the size of a large map
+static constexpr int WORLD_CHUNKS = 4096 / Chunk::CHUNK_WIDTH;
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// a few materials in patches, so chunks get 2 or 4 bit palettes like real terrain
+static void generate(World& world) {
+    std::mt19937 random{7};
+    std::uniform_int_distribution<int> material{0, 11};
+
+    for (int chunkX = 0; chunkX < WORLD_CHUNKS; chunkX++) {
+        for (int chunkY = 0; chunkY < WORLD_CHUNKS; chunkY++) {
+            Chunk& chunk = world.getChunkAt({chunkX, chunkY});
+            auto ground = static_cast<TileId>(material(random));
+            auto patch  = static_cast<TileId>(material(random));
+            for (int x = 0; x < static_cast<int>(Chunk::CHUNK_WIDTH); x++) {
+                for (int y = 0; y < static_cast<int>(Chunk::CHUNK_HEIGHT); y++) {
+                    chunk.setTileAt({x, y}, Tile{(x ^ y) % 5 == 0 ? patch : ground, 0});
+                }
+            }
+        }
+    }
+}
+
+static std::uintmax_t directorySize(const std::string& directory) {
+    std::uintmax_t size = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        size += entry.file_size();
+    }
+    return size;
+}
+
+// out of the page cache, so reads hit the disk like on a fresh start
+static void evictCache(const std::string& directory) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        int descriptor = open(entry.path().c_str(), O_RDONLY);
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+        close(descriptor);
+    }
+}
+
+// a player running across the map, 2 tiles a tick, with the chunks in view
+// and the ones a second ahead requested every tick like the server does
+static void walk(const std::string& directory, ChunkIO* io) {
+    constexpr int TICKS = 2000;
+    constexpr int RADIUS = 2;
+    constexpr float SPEED = 2;
+
+    evictCache(directory);
+    World world{0, "bench"};
+    world.open(directory, io);
+
+    std::vector<double> ticks{};
+    for (int tick = 0; tick < TICKS; tick++) {
+        auto start = std::chrono::steady_clock::now();
+
+        float x = static_cast<float>(tick) * SPEED;
+        float y = 2048;
+        for (float ahead : {0.0f, SPEED * 60}) {
+            int centerX = static_cast<int>((x + ahead) / Chunk::CHUNK_WIDTH);
+            int centerY = static_cast<int>(y / Chunk::CHUNK_HEIGHT);
+            for (int chunkX = centerX - RADIUS; chunkX <= centerX + RADIUS; chunkX++) {
+                for (int chunkY = centerY - RADIUS; chunkY <= centerY + RADIUS; chunkY++) {
+                    world.requestChunk({chunkX, chunkY});
+                }
+            }
+        }
+        world.installLoads();
+
+        ticks.push_back(millisSince(start));
+    }
+
+    std::sort(ticks.begin(), ticks.end());
+    double total = 0;
+    for (double tick : ticks) {
+        total += tick;
+    }
+    std::cout << (io == nullptr ? "Walk, loads on the tick: " : "Walk, loads on ChunkIO:  ")
+              << total / TICKS << " ms mean, " << ticks[TICKS * 99 / 100] << " ms p99, "
+              << ticks.back() << " ms max" << std::endl;
+}
+
+int main() {
+    std::string directory = (std::filesystem::temp_directory_path() / "RegionFileBench").string();
+    std::filesystem::remove_all(directory);
+
+    std::cout << std::fixed << std::setprecision(3);
+    {
+        World world{0, "bench"};
+        world.open(directory);
+        generate(world);
+
+        auto start = std::chrono::steady_clock::now();
+        std::size_t saved = world.save();
+        std::cout << "Save " << saved << " chunks: " << millisSince(start) << " ms, "
+                  << directorySize(directory) / 1024 << " KiB on disk" << std::endl;
+    }
+
+    World world{0, "bench"};
+    auto start = std::chrono::steady_clock::now();
+    world.open(directory);
+    std::cout << "Open: " << millisSince(start) << " ms" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    Tile first = world.getChunkAt({WORLD_CHUNKS / 2, WORLD_CHUNKS / 2}).getTileAt({0, 0});
+    std::cout << "First chunk: " << millisSince(start) << " ms" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    std::size_t patched = 0;
+    for (int chunkX = 0; chunkX < WORLD_CHUNKS; chunkX++) {
+        for (int chunkY = 0; chunkY < WORLD_CHUNKS; chunkY++) {
+            patched += world.getChunkAt({chunkX, chunkY}).getTileAt({0, 0}) != first;
+        }
+    }
+    double elapsed = millisSince(start);
+    std::cout << "Load every chunk: " << elapsed << " ms, "
+              << elapsed * 1000 / (WORLD_CHUNKS * WORLD_CHUNKS) << " us/chunk (" << patched << ")" << std::endl;
+
+    walk(directory, nullptr);
+    ChunkIO io{};
+    walk(directory, &io);
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
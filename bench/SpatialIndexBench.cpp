@@ -0,0 +1,91 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "SpatialIndex.h"
+
+using namespace mcplus;
+
+// a 1024x1024 tiles world, bigger than the biggest Minicraft+ map
+static constexpr float WORLD_SIZE = 1024;
+static constexpr int QUERY_COUNT  = 10000;
+
+template<typename Function>
+static void run(const char* name, std::size_t entityCount, std::size_t iterations, Function function) {
+    std::size_t found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        found += function(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(8) << entityCount << std::setw(16) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << elapsed.count() / iterations << " ns/op"
+              << std::setw(10) << static_cast<double>(found) / iterations << " found/op" << std::endl;
+}
+
+static void bench(std::size_t entityCount) {
+    std::mt19937 random{42};
+    std::uniform_real_distribution<float> coordinate{0, WORLD_SIZE};
+    std::uniform_real_distribution<float> step{-0.5f, 0.5f};
+
+    std::vector<Vector2f> positions(entityCount);
+    for (auto& position : positions) {
+        position = {coordinate(random), coordinate(random)};
+    }
+
+    std::vector<Vector2f> centers(QUERY_COUNT);
+    for (auto& center : centers) {
+        center = {coordinate(random), coordinate(random)};
+    }
+
+    SpatialHash index{};
+    run("insert", entityCount, entityCount, [&](std::size_t i) {
+        index.insert(static_cast<EntityId>(i), positions[i]);
+        return 0;
+    });
+
+    run("move", entityCount, entityCount, [&](std::size_t i) {
+        Vector2f to{positions[i].x + step(random), positions[i].y + step(random)};
+        index.move(static_cast<EntityId>(i), positions[i], to);
+        positions[i] = to;
+        return 0;
+    });
+
+    std::vector<EntityId> result{};
+    result.reserve(1024);
+
+    run("radius 16", entityCount, QUERY_COUNT, [&](std::size_t i) {
+        result.clear();
+        index.query(Circle2f{centers[i], 16}, result);
+        return result.size();
+    });
+
+    run("rectangle 32", entityCount, QUERY_COUNT, [&](std::size_t i) {
+        result.clear();
+        index.query(Rectangle2f{centers[i], 32, 32}, result);
+        return result.size();
+    });
+
+    // what every query costs without an index
+    run("linear radius", entityCount, QUERY_COUNT / 10, [&](std::size_t i) {
+        std::size_t found = 0;
+        for (const auto& position : positions) {
+            float dx = position.x - centers[i].x;
+            float dy = position.y - centers[i].y;
+            found += dx * dx + dy * dy <= 16 * 16;
+        }
+        return found;
+    });
+}
+
+int main() {
+    bench(10000);
+    bench(100000);
+
+    return 0;
+}
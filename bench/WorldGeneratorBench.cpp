@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "World.h"
+#include "WorldGenerator.h"
+#include "JobSystem.h"
+
+using namespace mcplus;
+
+// the map the server generates at startup, on every level
+static constexpr int MAP_CHUNKS = 1024 / Chunk::CHUNK_WIDTH;
+static constexpr WorldId LEVELS[] = {1, 0, -1, -2, -3, -4};
+static constexpr WorldSeed SEED = 0x5EED;
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// every level encoded one after the other, to compare runs byte for byte
+static std::string generateMap(const WorldGenerator& generator, JobSystem* jobs, const std::string& label) {
+    std::deque<World> worlds{};
+
+    auto start = std::chrono::steady_clock::now();
+    for (WorldId level : LEVELS) {
+        World& world = worlds.emplace_back(level, "bench");
+        world.setGenerator(&generator);
+        world.pregenerate({0, 0}, {MAP_CHUNKS, MAP_CHUNKS}, jobs);
+    }
+    double elapsed = millisSince(start);
+
+    std::string encoded{};
+    std::size_t memory = 0;
+    for (World& world : worlds) {
+        for (int chunkX = 0; chunkX < MAP_CHUNKS; chunkX++) {
+            for (int chunkY = 0; chunkY < MAP_CHUNKS; chunkY++) {
+                world.getChunkAt({chunkX, chunkY}).encode(encoded);
+            }
+        }
+        memory += world.memoryUsage();
+    }
+
+    std::cout << label << elapsed << " ms, " << elapsed * 1000 / (MAP_CHUNKS * MAP_CHUNKS * std::size(LEVELS))
+              << " us/chunk, " << memory / 1024 << " KiB" << std::endl;
+    return encoded;
+}
+
+int main() {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "1024x1024 tiles on " << std::size(LEVELS) << " levels, AVX2 "
+              << (WorldGenerator::hasAvx2() ? "available" : "unavailable") << std::endl;
+
+    WorldGenerator generator{SEED};
+    // a few threads even on a small machine, so the comparison means something
+    JobSystem jobs{std::max<std::size_t>(JobSystem::defaultThreadCount(), 3)};
+    std::string parallel = generateMap(generator, &jobs, "Jobs (" + std::to_string(jobs.size()) + " threads): ");
+    std::string serial   = generateMap(generator, nullptr, "One thread: ");
+
+    generator.setAvx2(false);
+    std::string scalar = generateMap(generator, &jobs, "Scalar noise: ");
+
+    bool same = parallel == serial && parallel == scalar;
+    std::cout << (same ? "Same terrain on every run" : "Terrain differs between runs") << std::endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include "ChunkIO.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+using namespace mcplus;
+
+ChunkIO::ChunkIO(std::size_t readThreads) {
+    this->failures = 0;
+    this->stopping = false;
+
+    this->threads.clear();
+    for (std::size_t i = 0; i < std::max<std::size_t>(readThreads, 1); i++) {
+        threads.emplace_back(&ChunkIO::work, this, std::ref(readLane));
+    }
+    threads.emplace_back(&ChunkIO::work, this, std::ref(writeLane));
+}
+
+ChunkIO::~ChunkIO() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    readLane.available.notify_all();
+    writeLane.available.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ChunkIO::work(Lane& lane) {
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true) {
+        lane.available.wait(lock, [this, &lane]() { return stopping || !lane.jobs.empty(); });
+        if (lane.jobs.empty()) {
+            // stopping, and nothing left to finish
+            return;
+        }
+
+        Job job = std::move(lane.jobs.front());
+        lane.jobs.pop_front();
+        lane.running++;
+        lock.unlock();
+
+        bool failed = false;
+        try {
+            job();
+        } catch (const std::exception& exception) {
+            // what failed is for the job to put back, the thread goes on with the next one
+            std::cerr << "Chunk I/O failed: " << exception.what() << std::endl;
+            failed = true;
+        }
+
+        lock.lock();
+        lane.running--;
+        lane.done++;
+        failures += failed;
+        if (readLane.jobs.empty() && readLane.running == 0 && writeLane.jobs.empty() && writeLane.running == 0) {
+            idle.notify_all();
+        }
+    }
+}
+
+void ChunkIO::submitRead(Job job) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        readLane.jobs.push_back(std::move(job));
+    }
+    readLane.available.notify_one();
+}
+
+void ChunkIO::submitWrite(Job job) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        writeLane.jobs.push_back(std::move(job));
+    }
+    writeLane.available.notify_one();
+}
+
+void ChunkIO::wait() {
+    std::unique_lock<std::mutex> lock{mutex};
+    idle.wait(lock, [this]() {
+        return readLane.jobs.empty() && readLane.running == 0 && writeLane.jobs.empty() && writeLane.running == 0;
+    });
+}
+
+ChunkIO::Statistics ChunkIO::getStatistics() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return {readLane.jobs.size(), writeLane.jobs.size(), readLane.done, writeLane.done, failures};
+}
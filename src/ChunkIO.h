@@ -0,0 +1,76 @@
+#ifndef MINICRAFTSERVER_CHUNKIO_H
+#define MINICRAFTSERVER_CHUNKIO_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcplus {
+
+    /**
+     * Threads doing the disk work of the worlds, so the tick never waits on it.
+     *
+     * Reads run on a small pool in no particular order. Writes run one at a
+     * time on their own thread in the order they were submitted, so two
+     * write-backs of the same region land in order and a busy writer never
+     * holds back the reads.
+     */
+    class ChunkIO {
+    public:
+        using Job = std::function<void()>;
+
+        static constexpr std::size_t DEFAULT_READ_THREADS = 2;
+
+        struct Statistics {
+            std::size_t queuedReads;
+            std::size_t queuedWrites;
+            std::uint64_t reads;
+            std::uint64_t writes;
+            std::uint64_t failures;
+        };
+    private:
+        struct Lane {
+            std::condition_variable available;
+            std::deque<Job> jobs;
+            std::size_t running = 0;
+            std::uint64_t done = 0;
+        };
+
+        mutable std::mutex mutex;
+        std::condition_variable idle;
+        Lane readLane;
+        Lane writeLane;
+        std::uint64_t failures;
+        bool stopping;
+
+        std::vector<std::thread> threads;
+
+        void work(Lane& lane);
+    public:
+        explicit ChunkIO(std::size_t readThreads = DEFAULT_READ_THREADS);
+        /**
+         * Finishes every job already submitted, writes included.
+         */
+        ~ChunkIO();
+
+        ChunkIO(const ChunkIO&) = delete;
+        ChunkIO& operator=(const ChunkIO&) = delete;
+
+        void submitRead(Job job);
+        void submitWrite(Job job);
+
+        /**
+         * Returns once every job submitted so far is done.
+         */
+        void wait();
+
+        [[nodiscard]] Statistics getStatistics() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_CHUNKIO_H
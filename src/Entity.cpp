@@ -1,205 +1,265 @@
 #include "Entity.h"
 #include "Utils.h"
 
-#include <sstream>
+#include <stdexcept>
 #include <utility>
 
 using namespace mcplus;
 
-static EntityId next_entity_id = 0;
-
 using EntityCreator = std::function<std::shared_ptr<Entity>(const std::string&, std::optional<EntitySolver> solver)>;
 
-static Location2f getLocationFromRaw(const std::string& raw);
+static Location2f getLocationFromRaw(std::string_view x, std::string_view y);
 static std::shared_ptr<Entity> createArrowEntity(const std::string& raw, std::optional<EntitySolver> solver);
 static std::shared_ptr<Entity> createItemEntity(const std::string& raw, std::optional<EntitySolver> solver);
 
-Entity::Field::Field(Entity::Field::Extractor extractor) : extractor(std::move(extractor)) {
-
+Entity::Entity(EntityStorage& storage, EntityId id) {
+    this->storage  = &storage;
+    this->entityId = id;
 }
 
-Entity::Data::Data(EntityId id, const Location2f& location, bool removed, const Entity::UpdateMapper& updateMap) {
-    this->id        = id;
-    this->location  = location;
-    this->removed   = removed;
-    this->updateMap = updateMap;
+Entity::~Entity() {
+    auto lock = lockStorage();
+    // rows in a world belong to the world, the detached ones to their handle
+    if (storage == &EntityStorage::detached() && storage->erase(entityId)) {
+        EntityIdAllocator::global().release(entityId);
+    }
 }
 
-Entity::Data::Data(EntityId id, const Location2f& location, bool removed) {
-    this->id        = id;
-    this->location  = location;
-    this->removed   = removed;
-    this->updateMap = {};
+std::unique_lock<std::recursive_mutex> Entity::lockStorage() const {
+    if (storage != &EntityStorage::detached()) {
+        // a world's storage is only touched by its own tick
+        return {};
+    }
+    return std::unique_lock<std::recursive_mutex>{EntityStorage::detachedMutex()};
 }
 
-Entity::Entity(std::shared_ptr<Data> data) {
-    this->_data = std::move(data);
+EntityId Entity::id() const {
+    return entityId;
 }
 
-Entity::Entity() {
-    this->_data = std::make_shared<Entity::Data>(next_entity_id++, Location2f{}, false);
+EntityStorage& Entity::getStorage() const {
+    return *storage;
 }
 
-EntityId Entity::id() const {
-    return _data->id;
+void Entity::moveTo(EntityStorage& storage) {
+    // either side may be the detached storage
+    std::unique_lock<std::recursive_mutex> lock{EntityStorage::detachedMutex(), std::defer_lock};
+    if (this->storage == &EntityStorage::detached() || &storage == &EntityStorage::detached()) {
+        lock.lock();
+    }
+    this->storage->transfer(entityId, storage);
+    this->storage = &storage;
 }
 
-const Location2f& Entity::getLocation() const {
-    return _data->location;
+Location2f Entity::getLocation() const {
+    auto lock = lockStorage();
+    return storage->getLocation(entityId);
 }
 
 void Entity::setLocation(const Location2f& location) {
-    auto fixedLocation = static_cast<FixedLocation>(location);
-
-    auto& actualLocation = _data->location;
-    auto& updateMap      = _data->updateMap;
-
-    if (actualLocation.x != location.x) {
-        updateMap[Entity::X_POSITION] = Field([fixedLocation]() {
-            return std::to_string(fixedLocation.x << 4 | fixedLocation.xDecimal);
-        });
-    }
-    if (actualLocation.y != location.y) {
-        updateMap[Entity::Y_POSITION] = Field([fixedLocation]() {
-            return std::to_string(fixedLocation.y << 4 | fixedLocation.yDecimal);
-        });
-    }
-    if (actualLocation.world != location.world) {
-        updateMap[Entity::LEVEL] = Field([location]() {
-            return std::to_string(location.world);
-        });
-    }
-
-    actualLocation = location;
+    auto lock = lockStorage();
+    storage->setLocation(entityId, location);
 }
 
 bool Entity::isRemoved() const {
-    return _data->removed;
+    auto lock = lockStorage();
+    return !storage->contains(entityId) || (storage->getFlags(entityId) & EntityStorage::REMOVED) != 0;
 }
 
 void Entity::remove() {
-    _data->removed = true;
+    auto lock = lockStorage();
+    storage->setFlags(entityId, EntityStorage::REMOVED);
 }
 
 std::string Entity::raw() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{24};
 
-    auto fixedLocation = static_cast<FixedLocation>(_data->location);
+    auto fixedLocation = static_cast<FixedLocation>(getLocation());
 
-    ss << (fixedLocation.x << 4 | fixedLocation.xDecimal) << ':';
-    ss << (fixedLocation.y << 4 | fixedLocation.yDecimal);
+    encoder << (fixedLocation.x << 4 | fixedLocation.xDecimal) << ':';
+    encoder << (fixedLocation.y << 4 | fixedLocation.yDecimal);
 
-    return ss.str();
+    return encoder.take();
 }
 
 std::string Entity::rawUpdate() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
+    writeUpdate(encoder);
+
+    return encoder.take();
+}
 
-    auto& updateMap = _data->updateMap;
+void Entity::writeUpdate(utils::TextEncoder& encoder) const {
+    auto lock = lockStorage();
+    uint32_t dirty = storage->getFlags(entityId) & EntityStorage::DIRTY;
+    if (dirty == 0) {
+        return;
+    }
 
-    if (!updateMap.empty()) {
-        auto it = updateMap.begin();
-        ss << it->first << ',' << it->second.extractor();
+    const auto& location = getLocation();
+    auto fixedLocation = static_cast<FixedLocation>(location);
+    bool first = true;
 
-        for (it = updateMap.erase(it); it != updateMap.end(); it = updateMap.erase(it)) {
-            ss << ';' << it->first << ',' << it->second.extractor();
+    auto field = [&encoder, &first](std::string_view name) -> utils::TextEncoder& {
+        if (!first) {
+            encoder << ';';
         }
-    }
+        first = false;
 
-    return ss.str();
-}
+        return encoder << name << ',';
+    };
 
-ArrowEntity::ArrowData::ArrowData(EntityId id, const Location2f& location, bool removed,
-                                  const Entity::UpdateMapper& updateMap, std::shared_ptr<Entity> owner,
-                                  Direction attackDirection, Damage_t damage) : Entity::Data(id, location, removed, updateMap) {
-    this->owner = std::move(owner);
-    this->attackDirection = attackDirection;
-    this->damage = damage;
-}
+    if (dirty & EntityStorage::X_POSITION) {
+        field("x") << (fixedLocation.x << 4 | fixedLocation.xDecimal);
+    }
+    if (dirty & EntityStorage::Y_POSITION) {
+        field("y") << (fixedLocation.y << 4 | fixedLocation.yDecimal);
+    }
+    if (dirty & EntityStorage::LEVEL) {
+        field("level") << location.world;
+    }
 
-ArrowEntity::ArrowData::ArrowData(EntityId id, const Location2f& location, bool removed, std::shared_ptr<Entity> owner,
-                                  Direction attackDirection, Damage_t damage) : Entity::Data(id, location, removed) {
-    this->owner = std::move(owner);
-    this->attackDirection = attackDirection;
-    this->damage = damage;
+    storage->clearFlags(entityId, EntityStorage::DIRTY);
 }
 
-ArrowEntity::ArrowEntity(std::shared_ptr<Entity::Data> data) : Entity(std::move(data)) {
-
+bool Entity::hasUpdate() const {
+    auto lock = lockStorage();
+    return storage->contains(entityId) && (storage->getFlags(entityId) & EntityStorage::DIRTY) != 0;
 }
 
 ArrowEntity::ArrowEntity(const Location2f& location,
-                         std::shared_ptr<Entity> owner,
+                         const std::shared_ptr<Entity>& owner,
                          Direction attackDirection,
-                         Damage_t damage) {
-    this->_data = std::make_shared<ArrowEntity::ArrowData>(next_entity_id++, location, false, std::move(owner), attackDirection, damage);
+                         Damage_t damage) : Entity(EntityStorage::detached(), EntityIdAllocator::global().allocate()) {
+    auto lock = lockStorage();
+    storage->createArrow(entityId, location, owner ? owner->id() : 0, attackDirection, damage);
 }
 
-ArrowEntity::ArrowEntity() : Entity() {
-    this->_data = std::make_shared<ArrowEntity::ArrowData>(next_entity_id++, Location2f{}, false, nullptr, Direction::NONE, 0);
+ArrowEntity::ArrowEntity() : ArrowEntity(Location2f{}, nullptr, Direction::NONE, 0) {
+
 }
 
 void ArrowEntity::tick() {
-
+    auto lock = lockStorage();
+    storage->tickArrow(storage->slotOf(entityId).row);
 }
 
 std::shared_ptr<Entity> ArrowEntity::get() const {
-    return std::shared_ptr<Entity>{new ArrowEntity()};
+    return std::const_pointer_cast<Entity>(shared_from_this());
 }
 
 std::string ArrowEntity::raw() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
+    auto lock = lockStorage();
+
+    const auto& arrows = storage->getArrows();
+    uint32_t row = storage->slotOf(entityId).row;
+
+    encoder << "Arrow["
+            << Entity::raw()                                         << ':'
+            << id()                                                  << ':'
+            << arrows.owners[row]                                    << ':'
+            << static_cast<int32_t>(arrows.attackDirections[row])    << ':'
+            << arrows.damages[row]                                   << ':'
+            << getLocation().world                                   << ']';
+
+    return encoder.take();
+}
+
+ItemEntity::ItemEntity(const Location2f& location, std::shared_ptr<Item> item, int32_t lifeTime)
+        : Entity(EntityStorage::detached(), EntityIdAllocator::global().allocate()) {
+    auto lock = lockStorage();
+    storage->createItem(entityId, location, std::move(item), lifeTime);
+}
+
+int32_t ItemEntity::getLifeTime() const {
+    auto lock = lockStorage();
+    return storage->getItems().lifeTimes[storage->slotOf(entityId).row];
+}
+
+std::shared_ptr<Item> ItemEntity::getItem() const {
+    auto lock = lockStorage();
+    return storage->getItems().items[storage->slotOf(entityId).row];
+}
+
+void ItemEntity::tick() {
+    auto lock = lockStorage();
+    storage->tickItem(storage->slotOf(entityId).row);
+}
+
+std::shared_ptr<Entity> ItemEntity::get() const {
+    return std::const_pointer_cast<Entity>(shared_from_this());
+}
+
+std::string ItemEntity::raw() const {
+    utils::TextEncoder encoder{};
+    auto lock = lockStorage();
 
-    const auto* data = dynamic_cast<ArrowEntity::ArrowData*>(_data.get());
-    const auto& owner = data->owner;
-    const auto& attackDirection = data->attackDirection;
-    const auto& damage = data->damage;
+    const auto& items = storage->getItems();
+    uint32_t row = storage->slotOf(entityId).row;
+    const auto& item = items.items[row];
 
-    ss << "Arrow["
-       << Entity::raw()                         << ':'
-       << id()                                  << ':'
-       << (owner ? owner->id() : 0)             << ':'
-       << static_cast<int32_t>(attackDirection) << ':'
-       << damage                                << ':'
-       << getLocation().world                   << ']';
+    encoder << "ItemEntity["
+            << Entity::raw()                         << ':'
+            << id()                                  << ':'
+            << (item ? item->raw() : "NULL")         << ':'
+            << items.lifeTimes[row]                  << ':'
+            << getLocation().world                   << ']';
 
-    return ss.str();
+    return encoder.take();
 }
 
 std::shared_ptr<Entity> mcplus::createEntity(const std::string& raw, std::optional<EntitySolver> solver) {
-    static std::unordered_map<std::string, EntityCreator> _data{
-            {"Arrow", createArrowEntity}
+    // only read, so every thread decoding may share it
+    static const std::unordered_map<std::string, EntityCreator> _data{
+            {"Arrow", createArrowEntity},
+            {"ItemEntity", createItemEntity}
     };
 
     std::string name = raw.substr(0, raw.find('['));
-    return _data[name](raw.substr(name.size() + 1, raw.size() - 1), std::move(solver));
+    auto creator = _data.find(name);
+    if (creator == _data.end()) {
+        throw std::invalid_argument("createEntity(): unknown entity " + name);
+    }
+    return creator->second(raw.substr(name.size() + 1, raw.size() - 1), std::move(solver));
 }
 
-static Location2f getLocationFromRaw(const std::string& raw) {
-    FixedLocation fixedLocation{static_cast<int32_t>(std::strtol(raw.substr(0, raw.find(':')).c_str(), nullptr, 10)),
-                                static_cast<int32_t>(std::strtol(raw.substr(raw.find(':') + 1).c_str(), nullptr, 10))};
+static Location2f getLocationFromRaw(std::string_view x, std::string_view y) {
+    FixedLocation fixedLocation{utils::parseNumber<int32_t>(x), utils::parseNumber<int32_t>(y)};
     return {0, fixedLocation, Direction::NONE};
 }
 
 static std::shared_ptr<Entity> createArrowEntity(const std::string& raw, std::optional<EntitySolver> solver) {
-    std::vector<std::string> dataList{};
-    dataList.reserve(5);
-    utils::splitString(raw, ":", dataList);
+    utils::FieldCursor cursor{raw, ':'};
+
+    auto x = cursor.next();
+    auto y = cursor.next();
 
     std::shared_ptr<Entity> solvedEntity{};
-    EntityId id = std::strtol(dataList[2].c_str(), nullptr, 10);
+    auto id = cursor.nextNumber<EntityId>();
 
     if (solver.has_value()) {
         solvedEntity = solver.value()(id);
     }
 
-    return std::make_shared<ArrowEntity>(getLocationFromRaw(dataList[0] + ':' + dataList[1]),
-                                         solvedEntity,
-                                         static_cast<Direction>(std::strtol(dataList[3].c_str(), nullptr, 10)),
-                                         std::strtol(dataList[4].c_str(), nullptr, 10));
+    auto direction = static_cast<Direction>(cursor.nextNumber<int32_t>());
+    auto damage = cursor.nextNumber<int32_t>();
+
+    return std::make_shared<ArrowEntity>(getLocationFromRaw(x, y), solvedEntity, direction, damage);
 }
 
-static std::shared_ptr<Entity> createItemEntity(const std::string& raw) {
-    return {};
+static std::shared_ptr<Entity> createItemEntity(const std::string& raw, std::optional<EntitySolver>) {
+    utils::FieldCursor cursor{raw, ':'};
+
+    auto x = cursor.next();
+    auto y = cursor.next();
+    // a new entity gets an id of its own
+    cursor.next();
+
+    auto itemRaw = cursor.next();
+    auto item = itemRaw == "NULL" ? nullptr : std::make_shared<Item>(std::string{itemRaw});
+    auto lifeTime = cursor.nextNumber<int32_t>();
+
+    return std::make_shared<ItemEntity>(getLocationFromRaw(x, y), std::move(item), lifeTime);
 }
 
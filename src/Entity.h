@@ -4,9 +4,12 @@
 #include "MinicraftDef.h"
 #include "Dimension.h"
 #include "Inventory.h"
+#include "Utils.h"
+#include "EntityStorage.h"
 
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <string_view>
 #include <functional>
 #include <optional>
@@ -51,44 +54,38 @@ namespace mcplus {
 
     using EntitySolver = std::function<std::shared_ptr<Entity>(EntityId)>;
 
-    class Entity : protected std::enable_shared_from_this<Entity> {
+    /**
+     * Handle to an entity kept in an EntityStorage, it holds no state itself.
+     *
+     * A world's storage owns the rows of the entities in it. Until a world
+     * takes it, the entity sits in EntityStorage::detached() and the handle
+     * owns its row there, every access locking EntityStorage::detachedMutex().
+     */
+    class Entity : public std::enable_shared_from_this<Entity> {
     protected:
-        // these are for updates
-        static constexpr std::string_view ID         = "eid";
-        static constexpr std::string_view X_POSITION = "x";
-        static constexpr std::string_view Y_POSITION = "y";
-        static constexpr std::string_view LEVEL      = "level";
+        EntityStorage* storage;
+        EntityId entityId;
 
-        struct Field {
-            using Extractor = std::function<std::string()>;
-
-            Extractor extractor;
-
-            explicit Field(Extractor extractor);
-            Field() = default;
-        };
-
-        using UpdateMapper = std::unordered_map<std::string_view, Field>;
-
-        struct Data {
-            EntityId id;
-            Location2f location;
-            bool removed;
-            UpdateMapper updateMap;
-
-            Data(EntityId id, const Location2f& location, bool removed, const UpdateMapper& updateMap);
-            Data(EntityId id, const Location2f& location, bool removed);
-            virtual ~Data() = default;
-        };
-
-        std::shared_ptr<Data> _data;
-
-        explicit Entity(std::shared_ptr<Data> data);
-        Entity();
+        Entity(EntityStorage& storage, EntityId id);
+        // holds EntityStorage::detachedMutex() while the entity is detached
+        [[nodiscard]] std::unique_lock<std::recursive_mutex> lockStorage() const;
     public:
-        [[nodiscard]] EntityId id() const;
+        Entity(const Entity&) = delete;
+        Entity& operator=(const Entity&) = delete;
+        virtual ~Entity();
 
-        const Location2f& getLocation() const;
+        [[nodiscard]] EntityId id() const;
+        [[nodiscard]] EntityStorage& getStorage() const;
+        /**
+         * Moves the entity's components into another storage, this handle follows it.
+         */
+        void moveTo(EntityStorage& storage);
+
+        // a copy, a detached row may move as soon as the lock is let go
+        Location2f getLocation() const;
+        /**
+         * Also keeps the entity's spot in its world's spatial index up to date.
+         */
         void setLocation(const Location2f& location);
 
         bool isRemoved() const;
@@ -98,27 +95,24 @@ namespace mcplus {
         virtual std::shared_ptr<Entity> get() const = 0;
 
         [[nodiscard]] virtual std::string raw() const;
-        [[nodiscard]] virtual std::string rawUpdate() const;
+        /**
+         * The fields changed since the last call, as "name,value;name,value".
+         */
+        [[nodiscard]] std::string rawUpdate() const;
+        /**
+         * Same as rawUpdate(), but appends to a buffer the caller reuses.
+         */
+        virtual void writeUpdate(utils::TextEncoder& encoder) const;
+        /**
+         * Whether rawUpdate() has something to say.
+         */
+        [[nodiscard]] bool hasUpdate() const;
     };
 
     class ArrowEntity : public Entity {
-        struct ArrowData : Entity::Data {
-            std::shared_ptr<Entity> owner;
-            Direction attackDirection;
-            Damage_t damage;
-
-            Vector2f acceleration;
-
-            ArrowData(EntityId id, const Location2f& location, bool removed, const UpdateMapper& updateMap,
-                      std::shared_ptr<Entity> owner, Direction attackDirection, Damage_t damage);
-            ArrowData(EntityId id, const Location2f& location, bool removed,
-                      std::shared_ptr<Entity> owner, Direction attackDirection, Damage_t damage);
-        };
-
-        explicit ArrowEntity(std::shared_ptr<Data> data);
     public:
         explicit ArrowEntity(const Location2f& location,
-                             std::shared_ptr<Entity> owner,
+                             const std::shared_ptr<Entity>& owner,
                              Direction attackDirection,
                              Damage_t damage);
         ArrowEntity();
@@ -131,8 +125,17 @@ namespace mcplus {
 
     class ItemEntity : public Entity {
     public:
-        int32_t lifeTime;
-        std::shared_ptr<Item> item;
+        explicit ItemEntity(const Location2f& location,
+                            std::shared_ptr<Item> item,
+                            int32_t lifeTime = EntityStorage::ITEM_LIFETIME);
+
+        [[nodiscard]] int32_t getLifeTime() const;
+        [[nodiscard]] std::shared_ptr<Item> getItem() const;
+
+        void tick() override;
+        std::shared_ptr<Entity> get() const override;
+
+        std::string raw() const override;
     };
 
     class Spark : public Entity {
@@ -0,0 +1,136 @@
+#include "EntityIdAllocator.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace mcplus;
+
+namespace {
+
+    // indices this thread can hand out or has given back, without locking
+    struct LocalCache {
+        std::vector<uint32_t> indices;
+
+        ~LocalCache() {
+            if (!indices.empty()) {
+                EntityIdAllocator::global().giveBatch(indices, indices.size());
+            }
+        }
+    };
+
+    thread_local LocalCache localCache{};
+
+}
+
+EntityIdAllocator::EntityIdAllocator() {
+    for (auto& segment : segments) {
+        segment.store(nullptr, std::memory_order_relaxed);
+    }
+    this->freeIndices = {};
+    // index 0 stays unused so NONE never names an entity
+    this->nextIndex   = 1;
+}
+
+EntityIdAllocator& EntityIdAllocator::global() {
+    static EntityIdAllocator _allocator{};
+    return _allocator;
+}
+
+std::atomic<uint8_t>& EntityIdAllocator::generationSlot(uint32_t index) {
+    // only called with the mutex held, or for an index this thread already owns
+    std::atomic<uint8_t>* segment = segments[index >> SEGMENT_BITS].load(std::memory_order_acquire);
+    return segment[index & (SEGMENT_SIZE - 1)];
+}
+
+const std::atomic<uint8_t>* EntityIdAllocator::findGenerationSlot(uint32_t index) const {
+    std::atomic<uint8_t>* segment = segments[index >> SEGMENT_BITS].load(std::memory_order_acquire);
+    if (segment == nullptr) {
+        return nullptr;
+    }
+    return &segment[index & (SEGMENT_SIZE - 1)];
+}
+
+void EntityIdAllocator::takeBatch(std::vector<uint32_t>& indices, std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    while (count > 0 && !freeIndices.empty()) {
+        indices.push_back(freeIndices.back());
+        freeIndices.pop_back();
+        count--;
+    }
+
+    for (; count > 0; count--) {
+        if (nextIndex > INDEX_MASK) {
+            if (indices.empty()) {
+                throw std::runtime_error("Ran out of entity ids");
+            }
+            break;
+        }
+
+        uint32_t segment = nextIndex >> SEGMENT_BITS;
+        if (segments[segment].load(std::memory_order_relaxed) == nullptr) {
+            auto& owned = ownedSegments.emplace_back(new std::atomic<uint8_t>[SEGMENT_SIZE]);
+            for (uint32_t i = 0; i < SEGMENT_SIZE; i++) {
+                owned[i].store(0, std::memory_order_relaxed);
+            }
+            segments[segment].store(owned.get(), std::memory_order_release);
+        }
+
+        indices.push_back(nextIndex++);
+    }
+}
+
+void EntityIdAllocator::giveBatch(std::vector<uint32_t>& indices, std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (; count > 0 && !indices.empty(); count--) {
+        freeIndices.push_back(indices.back());
+        indices.pop_back();
+    }
+}
+
+EntityId EntityIdAllocator::allocate() {
+    std::vector<uint32_t>& cache = localCache.indices;
+    if (cache.empty()) {
+        takeBatch(cache, BATCH_SIZE);
+    }
+
+    uint32_t index = cache.back();
+    cache.pop_back();
+
+    std::atomic<uint8_t>& slot = generationSlot(index);
+    uint8_t generation = slot.load(std::memory_order_relaxed) & GENERATION_MASK;
+    slot.store(generation | ALIVE, std::memory_order_release);
+
+    return (static_cast<EntityId>(generation) << INDEX_BITS) | index;
+}
+
+void EntityIdAllocator::release(EntityId id) {
+    uint32_t index = indexOf(id);
+    if (!isAlive(id)) {
+        throw std::logic_error("Entity id " + std::to_string(id) + " released twice");
+    }
+
+    // bumping the generation is what makes copies of the old id stale
+    std::atomic<uint8_t>& slot = generationSlot(index);
+    slot.store((generationOf(id) + 1) & GENERATION_MASK, std::memory_order_release);
+
+    std::vector<uint32_t>& cache = localCache.indices;
+    cache.push_back(index);
+    if (cache.size() >= BATCH_SIZE * 2) {
+        giveBatch(cache, BATCH_SIZE);
+    }
+}
+
+bool EntityIdAllocator::isAlive(EntityId id) const {
+    if (id == NONE || id >> (INDEX_BITS + GENERATION_BITS) != 0) {
+        return false;
+    }
+
+    const std::atomic<uint8_t>* slot = findGenerationSlot(indexOf(id));
+    if (slot == nullptr) {
+        return false;
+    }
+
+    return slot->load(std::memory_order_acquire) == (generationOf(id) | ALIVE);
+}
@@ -0,0 +1,82 @@
+#ifndef MINICRAFTSERVER_ENTITYIDALLOCATOR_H
+#define MINICRAFTSERVER_ENTITYIDALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MinicraftDef.h"
+
+namespace mcplus {
+
+    /**
+     * Hands out entity ids as a dense index plus a generation.
+     *
+     * Indices are reused once released, but every release bumps the
+     * generation, so an id kept from before (say, in a client packet) no
+     * longer matches and isAlive() tells it apart. Ids stay below 2^31 so
+     * the Java client still reads them as positive ints, and 0 is never
+     * handed out so it keeps meaning "no entity".
+     *
+     * Threads take and give back indices in batches through a thread local
+     * cache, the shared free list is only locked once per batch.
+     */
+    class EntityIdAllocator {
+    public:
+        static constexpr uint32_t INDEX_BITS      = 24;
+        static constexpr uint32_t GENERATION_BITS = 7;
+        static constexpr uint32_t INDEX_MASK      = (1u << INDEX_BITS) - 1;
+        static constexpr uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+        static constexpr EntityId NONE            = 0;
+
+        static constexpr std::size_t BATCH_SIZE = 64;
+    private:
+        static constexpr uint32_t SEGMENT_BITS  = 16;
+        static constexpr uint32_t SEGMENT_SIZE  = 1u << SEGMENT_BITS;
+        static constexpr uint32_t SEGMENT_COUNT = 1u << (INDEX_BITS - SEGMENT_BITS);
+        // set in a generation slot while its index is handed out
+        static constexpr uint8_t ALIVE = 0x80;
+
+        // generation of every index, allocated a segment at a time so lookups never lock
+        std::array<std::atomic<std::atomic<uint8_t>*>, SEGMENT_COUNT> segments;
+        std::vector<std::unique_ptr<std::atomic<uint8_t>[]>> ownedSegments;
+
+        std::mutex mutex;
+        std::vector<uint32_t> freeIndices;
+        uint32_t nextIndex;
+
+        EntityIdAllocator();
+
+        std::atomic<uint8_t>& generationSlot(uint32_t index);
+        [[nodiscard]] const std::atomic<uint8_t>* findGenerationSlot(uint32_t index) const;
+    public:
+        EntityIdAllocator(const EntityIdAllocator&) = delete;
+        EntityIdAllocator& operator=(const EntityIdAllocator&) = delete;
+
+        static EntityIdAllocator& global();
+
+        static uint32_t indexOf(EntityId id) {
+            return id & INDEX_MASK;
+        }
+
+        static uint32_t generationOf(EntityId id) {
+            return (id >> INDEX_BITS) & GENERATION_MASK;
+        }
+
+        EntityId allocate();
+        void release(EntityId id);
+        [[nodiscard]] bool isAlive(EntityId id) const;
+
+        /**
+         * Fills indices with up to count fresh indices, for the thread caches.
+         */
+        void takeBatch(std::vector<uint32_t>& indices, std::size_t count);
+        void giveBatch(std::vector<uint32_t>& indices, std::size_t count);
+    };
+
+}
+
+#endif // MINICRAFTSERVER_ENTITYIDALLOCATOR_H
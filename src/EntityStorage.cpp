@@ -0,0 +1,422 @@
+#include "EntityStorage.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using namespace mcplus;
+
+template<typename T>
+static void swapRemove(std::vector<T>& column, uint32_t row) {
+    if (row + 1 != column.size()) {
+        column[row] = std::move(column.back());
+    }
+    column.pop_back();
+}
+
+static Vector2f velocityOf(Direction direction, float speed) {
+    switch (direction) {
+        case Direction::DOWN:
+            return {0, speed};
+        case Direction::UP:
+            return {0, -speed};
+        case Direction::LEFT:
+            return {-speed, 0};
+        case Direction::RIGHT:
+            return {speed, 0};
+        default:
+            return {0, 0};
+    }
+}
+
+static uint32_t dirtyOf(const Location2f& from, const Location2f& to) {
+    uint32_t dirty = 0;
+    if (from.x != to.x) {
+        dirty |= EntityStorage::X_POSITION;
+    }
+    if (from.y != to.y) {
+        dirty |= EntityStorage::Y_POSITION;
+    }
+    if (from.world != to.world) {
+        dirty |= EntityStorage::LEVEL;
+    }
+
+    return dirty;
+}
+
+std::size_t EntityStorage::Table::size() const {
+    return ids.size();
+}
+
+EntityStorage::EntityStorage() {
+    this->slots        = {};
+    this->entityCount  = 0;
+    this->spatialIndex = nullptr;
+    this->levelChanges = {};
+    this->deferredSlices = {};
+}
+
+EntityStorage& EntityStorage::detached() {
+    static EntityStorage _storage{};
+    return _storage;
+}
+
+std::recursive_mutex& EntityStorage::detachedMutex() {
+    static std::recursive_mutex _mutex{};
+    return _mutex;
+}
+
+EntityStorage::Table& EntityStorage::tableOf(EntityType type) {
+    if (type == EntityType::ARROW) {
+        return arrows;
+    }
+    return items;
+}
+
+const EntityStorage::Table& EntityStorage::tableOf(EntityType type) const {
+    if (type == EntityType::ARROW) {
+        return arrows;
+    }
+    return items;
+}
+
+const EntityStorage::Slot* EntityStorage::findSlot(EntityId id) const {
+    uint32_t index = EntityIdAllocator::indexOf(id);
+    if (index >= slots.size() || slots[index].id != id || id == EntityIdAllocator::NONE) {
+        return nullptr;
+    }
+
+    return &slots[index];
+}
+
+void EntityStorage::setSlot(EntityId id, EntityType type, uint32_t row) {
+    uint32_t index = EntityIdAllocator::indexOf(id);
+    if (index >= slots.size()) {
+        slots.resize(index + 1, Slot{EntityIdAllocator::NONE, EntityType::ARROW, 0});
+    }
+
+    if (slots[index].id == EntityIdAllocator::NONE) {
+        entityCount++;
+    }
+    slots[index] = Slot{id, type, row};
+}
+
+uint32_t EntityStorage::pushRow(Table& table, EntityId id, const Location2f& location, const Vector2f& velocity, uint32_t flags) {
+    if (findSlot(id) != nullptr) {
+        throw std::logic_error("Entity " + std::to_string(id) + " is already stored");
+    }
+
+    auto row = static_cast<uint32_t>(table.size());
+
+    table.ids.push_back(id);
+    table.locations.push_back(location);
+    table.velocities.push_back(velocity);
+    table.flags.push_back(flags);
+
+    if (spatialIndex != nullptr) {
+        spatialIndex->insert(id, static_cast<Vector2f>(location));
+    }
+
+    return row;
+}
+
+void EntityStorage::eraseRow(EntityType type, uint32_t row) {
+    Table& table = tableOf(type);
+
+    EntityId id   = table.ids[row];
+    EntityId last = table.ids.back();
+
+    if (spatialIndex != nullptr) {
+        spatialIndex->remove(id, static_cast<Vector2f>(table.locations[row]));
+    }
+
+    swapRemove(table.ids, row);
+    swapRemove(table.locations, row);
+    swapRemove(table.velocities, row);
+    swapRemove(table.flags, row);
+
+    if (type == EntityType::ARROW) {
+        swapRemove(arrows.owners, row);
+        swapRemove(arrows.attackDirections, row);
+        swapRemove(arrows.damages, row);
+        swapRemove(arrows.lifeTimes, row);
+    } else {
+        swapRemove(items.items, row);
+        swapRemove(items.lifeTimes, row);
+    }
+
+    slots[EntityIdAllocator::indexOf(id)].id = EntityIdAllocator::NONE;
+    entityCount--;
+    if (last != id) {
+        slots[EntityIdAllocator::indexOf(last)].row = row;
+    }
+}
+
+void EntityStorage::moveRow(uint32_t row, const Location2f& to, Table& table) {
+    Location2f& location = table.locations[row];
+
+    uint32_t dirty = dirtyOf(location, to);
+    table.flags[row] |= dirty;
+
+    if (dirty & LEVEL) {
+        levelChanges.push_back(table.ids[row]);
+    }
+
+    if (spatialIndex != nullptr && (dirty & (X_POSITION | Y_POSITION))) {
+        spatialIndex->move(table.ids[row], static_cast<Vector2f>(location), static_cast<Vector2f>(to));
+    }
+
+    location = to;
+}
+
+void EntityStorage::createArrow(EntityId id, const Location2f& location, EntityId owner, Direction attackDirection, Damage_t damage) {
+    uint32_t row = pushRow(arrows, id, location, velocityOf(attackDirection, ARROW_SPEED), 0);
+
+    arrows.owners.push_back(owner);
+    arrows.attackDirections.push_back(attackDirection);
+    arrows.damages.push_back(damage);
+    arrows.lifeTimes.push_back(ARROW_LIFETIME);
+
+    setSlot(id, EntityType::ARROW, row);
+}
+
+void EntityStorage::createItem(EntityId id, const Location2f& location, std::shared_ptr<Item> item, int32_t lifeTime) {
+    uint32_t row = pushRow(items, id, location, Vector2f{}, 0);
+
+    items.items.push_back(std::move(item));
+    items.lifeTimes.push_back(lifeTime);
+
+    setSlot(id, EntityType::ITEM, row);
+}
+
+bool EntityStorage::contains(EntityId id) const {
+    return findSlot(id) != nullptr;
+}
+
+EntityStorage::Slot EntityStorage::slotOf(EntityId id) const {
+    const Slot* slot = findSlot(id);
+    if (slot == nullptr) {
+        throw std::logic_error("Entity " + std::to_string(id) + " doesn't exist here");
+    }
+
+    return *slot;
+}
+
+const Location2f& EntityStorage::getLocation(EntityId id) const {
+    Slot slot = slotOf(id);
+    return tableOf(slot.type).locations[slot.row];
+}
+
+void EntityStorage::setLocation(EntityId id, const Location2f& location) {
+    Slot slot = slotOf(id);
+    moveRow(slot.row, location, tableOf(slot.type));
+}
+
+uint32_t EntityStorage::getFlags(EntityId id) const {
+    Slot slot = slotOf(id);
+    return tableOf(slot.type).flags[slot.row];
+}
+
+void EntityStorage::setFlags(EntityId id, uint32_t flags) {
+    Slot slot = slotOf(id);
+    tableOf(slot.type).flags[slot.row] |= flags;
+}
+
+void EntityStorage::clearFlags(EntityId id, uint32_t flags) {
+    Slot slot = slotOf(id);
+    tableOf(slot.type).flags[slot.row] &= ~flags;
+}
+
+const EntityStorage::ArrowTable& EntityStorage::getArrows() const {
+    return arrows;
+}
+
+const EntityStorage::ItemTable& EntityStorage::getItems() const {
+    return items;
+}
+
+void EntityStorage::setSpatialIndex(SpatialHash* spatialIndex) {
+    this->spatialIndex = spatialIndex;
+}
+
+void EntityStorage::transfer(EntityId id, EntityStorage& storage) {
+    if (&storage == this) {
+        return;
+    }
+
+    Slot slot = slotOf(id);
+    uint32_t row = slot.row;
+
+    if (slot.type == EntityType::ARROW) {
+        uint32_t newRow = storage.pushRow(storage.arrows, id, arrows.locations[row], arrows.velocities[row], arrows.flags[row]);
+
+        storage.arrows.owners.push_back(arrows.owners[row]);
+        storage.arrows.attackDirections.push_back(arrows.attackDirections[row]);
+        storage.arrows.damages.push_back(arrows.damages[row]);
+        storage.arrows.lifeTimes.push_back(arrows.lifeTimes[row]);
+
+        storage.setSlot(id, EntityType::ARROW, newRow);
+    } else {
+        uint32_t newRow = storage.pushRow(storage.items, id, items.locations[row], items.velocities[row], items.flags[row]);
+
+        storage.items.items.push_back(items.items[row]);
+        storage.items.lifeTimes.push_back(items.lifeTimes[row]);
+
+        storage.setSlot(id, EntityType::ITEM, newRow);
+    }
+
+    eraseRow(slot.type, row);
+}
+
+bool EntityStorage::erase(EntityId id) {
+    const Slot* slot = findSlot(id);
+    if (slot == nullptr) {
+        return false;
+    }
+
+    eraseRow(slot->type, slot->row);
+    return true;
+}
+
+void EntityStorage::stepRow(uint32_t row, const Location2f& to, Table& table, std::vector<Deferred>* deferred) {
+    if (deferred == nullptr) {
+        moveRow(row, to, table);
+        return;
+    }
+
+    Location2f& location = table.locations[row];
+
+    uint32_t dirty = dirtyOf(location, to);
+    table.flags[row] |= dirty;
+
+    auto from = static_cast<Vector2f>(location);
+    bool cellChanged = spatialIndex != nullptr && (dirty & (X_POSITION | Y_POSITION))
+                       && !spatialIndex->moveWithinCell(table.ids[row], from, static_cast<Vector2f>(to));
+    if (cellChanged || (dirty & LEVEL)) {
+        deferred->push_back({row, from, cellChanged, (dirty & LEVEL) != 0});
+    }
+
+    location = to;
+}
+
+void EntityStorage::applyDeferred(Table& table, std::vector<Deferred>& deferred) {
+    for (const auto& step : deferred) {
+        if (step.cellChanged) {
+            spatialIndex->move(table.ids[step.row], step.from, static_cast<Vector2f>(table.locations[step.row]));
+        }
+        if (step.levelChanged) {
+            levelChanges.push_back(table.ids[step.row]);
+        }
+    }
+    deferred.clear();
+}
+
+void EntityStorage::stepArrow(uint32_t row, std::vector<Deferred>* deferred) {
+    if (arrows.flags[row] & REMOVED) {
+        return;
+    }
+
+    if (--arrows.lifeTimes[row] <= 0) {
+        arrows.flags[row] |= REMOVED;
+        return;
+    }
+
+    stepRow(row, arrows.locations[row] + arrows.velocities[row], arrows, deferred);
+}
+
+void EntityStorage::stepItem(uint32_t row, std::vector<Deferred>* deferred) {
+    if (items.flags[row] & REMOVED) {
+        return;
+    }
+
+    if (--items.lifeTimes[row] <= 0) {
+        items.flags[row] |= REMOVED;
+        return;
+    }
+
+    Vector2f& velocity = items.velocities[row];
+    if (velocity.x != 0 || velocity.y != 0) {
+        stepRow(row, items.locations[row] + velocity, items, deferred);
+
+        // dropped items slide a little and stop
+        velocity *= Vector2f{0.6f, 0.6f};
+        if (std::abs(velocity.x) < 0.01f && std::abs(velocity.y) < 0.01f) {
+            velocity = {0, 0};
+        }
+    }
+}
+
+template<typename F>
+void EntityStorage::tickRows(Table& table, JobSystem* jobs, F&& step) {
+    std::size_t count = table.size();
+
+    // alone, moving right away gives the same index as deferring, only sooner
+    if (jobs == nullptr || jobs->size() == 0 || count <= TICK_GRAIN) {
+        for (uint32_t row = 0; row < count; row++) {
+            step(row, nullptr);
+        }
+        return;
+    }
+
+    std::size_t sliceCount = (count + TICK_GRAIN - 1) / TICK_GRAIN;
+    if (deferredSlices.size() < sliceCount) {
+        deferredSlices.resize(sliceCount);
+    }
+
+    // slices start at multiples of TICK_GRAIN, each one has its own deferred list
+    jobs->parallelFor(count, TICK_GRAIN, [this, &step](std::size_t begin, std::size_t end) {
+        std::vector<Deferred>& deferred = deferredSlices[begin / TICK_GRAIN];
+        for (auto row = static_cast<uint32_t>(begin); row < end; row++) {
+            step(row, &deferred);
+        }
+    });
+
+    for (std::size_t slice = 0; slice < sliceCount; slice++) {
+        applyDeferred(table, deferredSlices[slice]);
+    }
+}
+
+void EntityStorage::tickArrow(uint32_t row) {
+    stepArrow(row, nullptr);
+}
+
+void EntityStorage::tickItem(uint32_t row) {
+    stepItem(row, nullptr);
+}
+
+void EntityStorage::tickArrows(JobSystem* jobs) {
+    tickRows(arrows, jobs, [this](uint32_t row, std::vector<Deferred>* deferred) {
+        stepArrow(row, deferred);
+    });
+}
+
+void EntityStorage::tickItems(JobSystem* jobs) {
+    tickRows(items, jobs, [this](uint32_t row, std::vector<Deferred>* deferred) {
+        stepItem(row, deferred);
+    });
+}
+
+void EntityStorage::sweep(std::vector<EntityId>& removed) {
+    for (EntityType type : {EntityType::ARROW, EntityType::ITEM}) {
+        Table& table = tableOf(type);
+
+        // backwards, so the row swapped in was already looked at
+        for (auto row = static_cast<uint32_t>(table.size()); row-- > 0;) {
+            if (table.flags[row] & REMOVED) {
+                removed.push_back(table.ids[row]);
+                eraseRow(type, row);
+            }
+        }
+    }
+}
+
+void EntityStorage::takeLevelChanges(std::vector<EntityId>& changed) {
+    changed.insert(changed.end(), levelChanges.begin(), levelChanges.end());
+    levelChanges.clear();
+}
+
+std::size_t EntityStorage::size() const {
+    return entityCount;
+}
@@ -0,0 +1,186 @@
+#ifndef MINICRAFTSERVER_ENTITYSTORAGE_H
+#define MINICRAFTSERVER_ENTITYSTORAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MinicraftDef.h"
+#include "Dimension.h"
+#include "Inventory.h"
+#include "SpatialIndex.h"
+#include "EntityIdAllocator.h"
+
+namespace mcplus {
+
+    class JobSystem;
+
+    enum class EntityType : uint8_t {
+        ARROW,
+        ITEM
+    };
+
+    /**
+     * Entity state kept as structure of arrays, one table per entity type.
+     *
+     * Rows are dense: removing one moves the last row into its place, so
+     * the tick systems walk plain arrays without any virtual call or
+     * pointer chasing. Entity objects are only handles into a storage.
+     */
+    class EntityStorage {
+    public:
+        enum Flag : uint32_t {
+            // fields changed since the last Entity::writeUpdate()
+            X_POSITION = 1 << 0,
+            Y_POSITION = 1 << 1,
+            LEVEL      = 1 << 2,
+            DIRTY      = X_POSITION | Y_POSITION | LEVEL,
+
+            REMOVED    = 1u << 31
+        };
+
+        struct Slot {
+            EntityId id; // EntityIdAllocator::NONE when free
+            EntityType type;
+            uint32_t row;
+        };
+
+        // columns every entity type has
+        struct Table {
+            std::vector<EntityId> ids;
+            std::vector<Location2f> locations;
+            std::vector<Vector2f> velocities;
+            std::vector<uint32_t> flags;
+
+            [[nodiscard]] std::size_t size() const;
+        };
+
+        struct ArrowTable : Table {
+            std::vector<EntityId> owners;
+            std::vector<Direction> attackDirections;
+            std::vector<Damage_t> damages;
+            std::vector<int32_t> lifeTimes;
+        };
+
+        struct ItemTable : Table {
+            std::vector<std::shared_ptr<Item>> items;
+            std::vector<int32_t> lifeTimes;
+        };
+
+        // in location units per tick and in ticks
+        static constexpr float ARROW_SPEED      = 2;
+        static constexpr int32_t ARROW_LIFETIME = 60 * 5;
+        static constexpr int32_t ITEM_LIFETIME  = 60 * 10;
+
+        // rows per job when the systems run on a JobSystem
+        static constexpr std::size_t TICK_GRAIN = 4096;
+    private:
+        // moves a parallel tick can't do by itself, done afterwards in row order
+        struct Deferred {
+            uint32_t row;
+            Vector2f from;
+            bool cellChanged;
+            bool levelChanged;
+        };
+
+        ArrowTable arrows;
+        ItemTable items;
+        // indexed by EntityIdAllocator::indexOf(), ids are dense so no hashing
+        std::vector<Slot> slots;
+        std::size_t entityCount;
+        SpatialHash* spatialIndex;
+        std::vector<EntityId> levelChanges;
+        std::vector<std::vector<Deferred>> deferredSlices;
+
+        Table& tableOf(EntityType type);
+        [[nodiscard]] const Table& tableOf(EntityType type) const;
+
+        [[nodiscard]] const Slot* findSlot(EntityId id) const;
+        void setSlot(EntityId id, EntityType type, uint32_t row);
+
+        uint32_t pushRow(Table& table, EntityId id, const Location2f& location, const Vector2f& velocity, uint32_t flags);
+        void eraseRow(EntityType type, uint32_t row);
+        void moveRow(uint32_t row, const Location2f& to, Table& table);
+        // moveRow() that only touches the row, leaving what it can't do to deferred, or moveRow() without it
+        void stepRow(uint32_t row, const Location2f& to, Table& table, std::vector<Deferred>* deferred);
+        void applyDeferred(Table& table, std::vector<Deferred>& deferred);
+
+        void stepArrow(uint32_t row, std::vector<Deferred>* deferred);
+        void stepItem(uint32_t row, std::vector<Deferred>* deferred);
+
+        template<typename F>
+        void tickRows(Table& table, JobSystem* jobs, F&& step);
+    public:
+        EntityStorage();
+
+        EntityStorage(const EntityStorage&) = delete;
+        EntityStorage& operator=(const EntityStorage&) = delete;
+
+        /**
+         * Where entities live until a world takes them, handles own their
+         * rows there. Every world's tick may create entities at once, so
+         * unlike a world's storage it is only used under detachedMutex().
+         */
+        static EntityStorage& detached();
+        static std::recursive_mutex& detachedMutex();
+
+        void createArrow(EntityId id, const Location2f& location, EntityId owner, Direction attackDirection, Damage_t damage);
+        void createItem(EntityId id, const Location2f& location, std::shared_ptr<Item> item, int32_t lifeTime);
+
+        [[nodiscard]] bool contains(EntityId id) const;
+        /**
+         * Throws std::logic_error when the entity isn't here.
+         */
+        [[nodiscard]] Slot slotOf(EntityId id) const;
+
+        [[nodiscard]] const Location2f& getLocation(EntityId id) const;
+        void setLocation(EntityId id, const Location2f& location);
+
+        [[nodiscard]] uint32_t getFlags(EntityId id) const;
+        void setFlags(EntityId id, uint32_t flags);
+        void clearFlags(EntityId id, uint32_t flags);
+
+        [[nodiscard]] const ArrowTable& getArrows() const;
+        [[nodiscard]] const ItemTable& getItems() const;
+
+        /**
+         * Index to keep up to date when entities move, null when none.
+         */
+        void setSpatialIndex(SpatialHash* spatialIndex);
+
+        /**
+         * Moves an entity and all its components into another storage.
+         */
+        void transfer(EntityId id, EntityStorage& storage);
+        bool erase(EntityId id);
+
+        void tickArrow(uint32_t row);
+        void tickItem(uint32_t row);
+
+        /**
+         * Ticks every row, split over jobs when given. Rows only change
+         * themselves, and the spatial index updates that reshape it are
+         * applied afterwards in row order, so the result doesn't depend on
+         * the thread count.
+         */
+        void tickArrows(JobSystem* jobs = nullptr);
+        void tickItems(JobSystem* jobs = nullptr);
+
+        /**
+         * Erases every removed entity, appending their ids to removed.
+         */
+        void sweep(std::vector<EntityId>& removed);
+
+        /**
+         * Appends the entities whose level changed since the last call.
+         * Some of them may be gone or back on their old level by now.
+         */
+        void takeLevelChanges(std::vector<EntityId>& changed);
+
+        [[nodiscard]] std::size_t size() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_ENTITYSTORAGE_H
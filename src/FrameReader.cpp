@@ -0,0 +1,142 @@
+#include "FrameReader.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace mcplus;
+
+static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+static std::size_t roundCapacity(std::size_t capacity) {
+    std::size_t rounded = 64;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+FrameReader::FrameReader(std::size_t capacity, std::size_t maxCapacity) {
+    this->capacity    = roundCapacity(capacity);
+    this->maxCapacity = maxCapacity;
+    this->buffer      = std::make_unique<char[]>(this->capacity);
+    this->head        = 0;
+    this->tail        = 0;
+    this->scanned     = 0;
+    this->syscalls    = 0;
+    this->bytesRead   = 0;
+}
+
+std::size_t FrameReader::index(std::size_t position) const {
+    return position & (capacity - 1);
+}
+
+// memchr over at most two contiguous segments of the ring
+std::size_t FrameReader::find(std::size_t from) const {
+    while (from < tail) {
+        std::size_t start = index(from);
+        std::size_t length = std::min(tail - from, capacity - start);
+
+        const auto* found = static_cast<const char*>(std::memchr(buffer.get() + start, '\0', length));
+        if (found != nullptr) {
+            return from + (found - (buffer.get() + start));
+        }
+        from += length;
+    }
+    return NOT_FOUND;
+}
+
+void FrameReader::grow() {
+    if (capacity >= maxCapacity) {
+        throw std::length_error("FrameReader: frame is too big");
+    }
+
+    std::size_t used = size();
+    auto grown = std::make_unique<char[]>(capacity * 2);
+
+    std::size_t start = index(head);
+    std::size_t first = std::min(used, capacity - start);
+    std::memcpy(grown.get(), buffer.get() + start, first);
+    std::memcpy(grown.get() + first, buffer.get(), used - first);
+
+    buffer   = std::move(grown);
+    capacity = capacity * 2;
+    tail     = used;
+    head     = 0;
+}
+
+std::size_t FrameReader::fill(const utils::Socket& socket) {
+    if (size() == capacity) {
+        // a single frame filled the whole ring
+        grow();
+    }
+
+    std::size_t start = index(tail);
+    std::size_t free = capacity - size();
+    std::size_t first = std::min(free, capacity - start);
+
+    iovec vectors[2] = {
+            {.iov_base = buffer.get() + start, .iov_len = first},
+            {.iov_base = buffer.get(), .iov_len = free - first}
+    };
+
+    syscalls++;
+    std::size_t read = socket.readSome(vectors, free - first > 0 ? 2 : 1);
+
+    tail += read;
+    bytesRead += read;
+
+    return read;
+}
+
+bool FrameReader::next(RawPacket& rawPacket) {
+    // the id byte can never be the terminator
+    if (size() < 2) {
+        return false;
+    }
+
+    std::size_t end = find(head + std::max<std::size_t>(1, scanned));
+    if (end == NOT_FOUND) {
+        scanned = size();
+        return false;
+    }
+
+    std::size_t length = end - head - 1;
+    rawPacket.id = static_cast<std::uint8_t>(buffer[index(head)]);
+    rawPacket.data.resize(length);
+
+    std::size_t start = index(head + 1);
+    std::size_t first = std::min(length, capacity - start);
+    std::memcpy(rawPacket.data.data(), buffer.get() + start, first);
+    std::memcpy(rawPacket.data.data() + first, buffer.get(), length - first);
+
+    head = end + 1;
+    scanned = 0;
+
+    if (head == tail) {
+        // keep the next fill contiguous
+        head = 0;
+        tail = 0;
+    }
+
+    return true;
+}
+
+std::size_t FrameReader::size() const {
+    return tail - head;
+}
+
+std::uint64_t FrameReader::getSyscalls() const {
+    return syscalls;
+}
+
+std::uint64_t FrameReader::getBytesRead() const {
+    return bytesRead;
+}
+
+RawPacket mcplus::readPacket(utils::Socket& socket, FrameReader& reader) {
+    RawPacket rawPacket{};
+    while (!reader.next(rawPacket)) {
+        reader.fill(socket);
+    }
+    return rawPacket;
+}
@@ -0,0 +1,71 @@
+#ifndef MINICRAFTSERVER_FRAMEREADER_H
+#define MINICRAFTSERVER_FRAMEREADER_H
+
+#include <cstdint>
+#include <memory>
+
+#include "Socket.h"
+#include "Protocol.h"
+
+namespace mcplus {
+
+    /**
+     * Per-connection ring buffer for the legacy protocol.
+     *
+     * A frame is one id byte followed by the payload and a '\0' terminator.
+     * The socket is read in bulk (one readv per fill, covering both free
+     * segments of the ring) and the terminator is found with memchr, so a
+     * packet costs no syscall of its own and its payload is copied once.
+     */
+    class FrameReader {
+    public:
+        static constexpr std::size_t DEFAULT_CAPACITY = 16 * 1024;
+        // clients only send small frames, anything past this is a bad one
+        static constexpr std::size_t MAX_CAPACITY     = 64 * 1024;
+    private:
+
+        std::unique_ptr<char[]> buffer;
+        std::size_t capacity; // always a power of two
+        std::size_t head;     // monotonic read position
+        std::size_t tail;     // monotonic write position
+        std::size_t scanned;  // bytes after head already known not to hold a terminator
+        std::size_t maxCapacity;
+
+        std::uint64_t syscalls;
+        std::uint64_t bytesRead;
+
+        [[nodiscard]] std::size_t index(std::size_t position) const;
+        [[nodiscard]] std::size_t find(std::size_t from) const;
+        void grow();
+    public:
+        /**
+         * maxCapacity is the biggest frame it takes, a client reading what
+         * the server sends needs more than MAX_CAPACITY.
+         */
+        explicit FrameReader(std::size_t capacity = DEFAULT_CAPACITY, std::size_t maxCapacity = MAX_CAPACITY);
+
+        /**
+         * Reads whatever the socket has available into the free space.
+         *
+         * Returns the amount of bytes read, 0 if the socket would block.
+         * Throws if the peer disconnected, or std::length_error if a frame
+         * outgrew the maximum capacity.
+         */
+        std::size_t fill(const utils::Socket& socket);
+
+        /**
+         * Moves the next complete frame into rawPacket, reusing its
+         * data capacity. Returns false if no complete frame is buffered.
+         */
+        bool next(RawPacket& rawPacket);
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::uint64_t getSyscalls() const;
+        [[nodiscard]] std::uint64_t getBytesRead() const;
+    };
+
+    RawPacket readPacket(utils::Socket& socket, FrameReader& reader);
+
+}
+
+#endif // MINICRAFTSERVER_FRAMEREADER_H
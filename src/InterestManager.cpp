@@ -0,0 +1,129 @@
+#include "InterestManager.h"
+#include "World.h"
+#include "Packet.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace mcplus;
+
+InterestManager::InterestManager(int viewRadius) {
+    this->viewRadius  = viewRadius;
+    this->subscribers = {};
+    this->deltaBuffer = utils::TextEncoder{4096};
+    this->deltas      = {};
+    this->visible     = {};
+    this->stillKnown  = {};
+}
+
+Rectangle2f InterestManager::viewOf(const Vector2f& position) const {
+    constexpr auto chunkWidth = static_cast<float>(Chunk::CHUNK_WIDTH);
+
+    float chunkX = std::floor(position.x / chunkWidth);
+    float chunkY = std::floor(position.y / chunkWidth);
+    float size   = static_cast<float>(viewRadius * 2 + 1) * chunkWidth;
+
+    return {(chunkX - static_cast<float>(viewRadius)) * chunkWidth, (chunkY - static_cast<float>(viewRadius)) * chunkWidth, size, size};
+}
+
+void InterestManager::subscribe(std::shared_ptr<utils::Socket> socket, const Vector2f& position) {
+    const utils::Socket* key = socket.get();
+    subscribers[key] = Subscriber{std::move(socket), position, {}};
+}
+
+void InterestManager::moveView(const utils::Socket& socket, const Vector2f& position) {
+    auto it = subscribers.find(&socket);
+    if (it != subscribers.end()) {
+        it->second.position = position;
+    }
+}
+
+bool InterestManager::unsubscribe(const utils::Socket& socket) {
+    auto it = subscribers.find(&socket);
+    if (it == subscribers.end()) {
+        return false;
+    }
+
+    // whatever it knew from this world is gone for it now
+    for (EntityId id : it->second.known) {
+        queuePacket(*it->second.socket, RemovePacket{id, {}});
+    }
+    subscribers.erase(it);
+
+    return true;
+}
+
+bool InterestManager::isSubscribed(const utils::Socket& socket) const {
+    return subscribers.find(&socket) != subscribers.end();
+}
+
+std::size_t InterestManager::size() const {
+    return subscribers.size();
+}
+
+void InterestManager::update(World& world) {
+    deltaBuffer.clear();
+    deltas.clear();
+    world.forEachEntity([this](const std::shared_ptr<Entity>& entity) {
+        if (entity->hasUpdate()) {
+            // same payload as EntityPacket, without a string per entity
+            std::size_t offset = deltaBuffer.size();
+            deltaBuffer << entity->id() << ';';
+            entity->writeUpdate(deltaBuffer);
+
+            deltas.push_back({entity->id(), offset, deltaBuffer.size() - offset});
+        }
+    });
+    std::sort(deltas.begin(), deltas.end(), [](const Delta& a, const Delta& b) { return a.id < b.id; });
+
+    for (auto it = subscribers.begin(); it != subscribers.end();) {
+        if (!it->second.socket->isConnected()) {
+            it = subscribers.erase(it);
+            continue;
+        }
+
+        updateSubscriber(world, it->second);
+        it++;
+    }
+}
+
+void InterestManager::updateSubscriber(const World& world, Subscriber& subscriber) {
+    utils::Socket& socket = *subscriber.socket;
+
+    visible.clear();
+    world.getSpatialIndex().forEachIn(viewOf(subscriber.position), [this](const SpatialHash::Entry& entry) {
+        visible.push_back(entry.id);
+    });
+
+    stillKnown.clear();
+    for (EntityId id : visible) {
+        if (subscriber.known.count(id) != 0) {
+            auto delta = std::lower_bound(deltas.begin(), deltas.end(), id, [](const Delta& delta, EntityId id) { return delta.id < id; });
+            if (delta != deltas.end() && delta->id == id) {
+                auto payload = deltaBuffer.view().substr(delta->offset, delta->length);
+                std::string data = utils::BufferPool::global().acquire();
+                data.assign(payload);
+                queuePacket(socket, RawPacket{static_cast<PacketId>(PacketType::ENTITY), std::move(data)});
+            }
+        } else {
+            auto entity = world.getEntity(id);
+            if (!entity) {
+                continue;
+            }
+            queuePacket(socket, AddPacket{entity});
+        }
+
+        stillKnown.insert(id);
+    }
+
+    for (EntityId id : subscriber.known) {
+        if (stillKnown.count(id) == 0) {
+            queuePacket(socket, RemovePacket{id, {}});
+        }
+    }
+
+    // the old set becomes next tick's scratch space
+    subscriber.known.swap(stillKnown);
+}
@@ -0,0 +1,76 @@
+#ifndef MINICRAFTSERVER_INTERESTMANAGER_H
+#define MINICRAFTSERVER_INTERESTMANAGER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MinicraftDef.h"
+#include "Dimension.h"
+#include "Socket.h"
+#include "Protocol.h"
+#include "Utils.h"
+
+namespace mcplus {
+
+    class World;
+
+    /**
+     * Decides which players hear about which entities of one world.
+     *
+     * Every player sees a square window of chunks around the chunk it stands
+     * on. Entities entering the window are sent as ADD, leaving it as REMOVE,
+     * and ENTITY deltas only go to the players whose window has the entity.
+     * The work per player depends on what is near it, not on how many
+     * entities the world has.
+     */
+    class InterestManager {
+        struct Subscriber {
+            std::shared_ptr<utils::Socket> socket;
+            Vector2f position;
+            std::unordered_set<EntityId> known;
+        };
+
+        int viewRadius;
+        std::unordered_map<const utils::Socket*, Subscriber> subscribers;
+
+        struct Delta {
+            EntityId id;
+            std::size_t offset;
+            std::size_t length;
+        };
+
+        // scratch space kept between ticks so updates don't allocate
+        utils::TextEncoder deltaBuffer;
+        std::vector<Delta> deltas; // sorted by id
+        std::vector<EntityId> visible;
+        std::unordered_set<EntityId> stillKnown;
+
+        [[nodiscard]] Rectangle2f viewOf(const Vector2f& position) const;
+        void updateSubscriber(const World& world, Subscriber& subscriber);
+    public:
+        // chunks around the player's own one, 5x5 chunks cover a Minicraft+ screen with room to spare
+        static constexpr int DEFAULT_VIEW_RADIUS = 2;
+
+        explicit InterestManager(int viewRadius = DEFAULT_VIEW_RADIUS);
+
+        void subscribe(std::shared_ptr<utils::Socket> socket, const Vector2f& position);
+        void moveView(const utils::Socket& socket, const Vector2f& position);
+        bool unsubscribe(const utils::Socket& socket);
+
+        [[nodiscard]] bool isSubscribed(const utils::Socket& socket) const;
+        [[nodiscard]] std::size_t size() const;
+
+        /**
+         * Collects the entity deltas of this tick, encoding each one once,
+         * and queues ADD/REMOVE/ENTITY packets to every subscriber.
+         * Disconnected subscribers are dropped on the way.
+         */
+        void update(World& world);
+    };
+
+}
+
+#endif // MINICRAFTSERVER_INTERESTMANAGER_H
@@ -1,7 +1,6 @@
 #include "Inventory.h"
 
 #include <unordered_map>
-#include <sstream>
 #include "Utils.h"
 
 using namespace mcplus;
@@ -136,27 +135,27 @@ const ItemData& Item::data() const {
 }
 
 std::string Item::raw() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
     if (checkBelongTo(ItemMaterial::TOOL_START, ItemMaterial::TOOL_END, _id)) {
         auto& toolData = dynamic_cast<ItemToolData&>(*_data);
-        ss << getToolLevelName(toolData.level) << ' ' << getItemName(_id);
+        encoder << getToolLevelName(toolData.level) << ' ' << getItemName(_id);
     } else if (checkBelongTo(ItemMaterial::STACKABLE_START, ItemMaterial::STACKABLE_END, _id)) {
         auto& stackableData = dynamic_cast<ItemStackableData&>(*_data);
 
         if (_id == static_cast<ItemId>(ItemMaterial::POTION)) {
             auto& potionData = dynamic_cast<ItemPotionData&>(stackableData);
-            ss << getPotionName(potionData.potion.type);
+            encoder << getPotionName(potionData.potion.type);
         } else {
-            ss << getItemName(_id);
+            encoder << getItemName(_id);
         }
 
-        ss << '_' << stackableData.amount;
+        encoder << '_' << stackableData.amount;
     } else {
-        ss << getItemName(_id);
+        encoder << getItemName(_id);
     }
 
-    return ss.str();
+    return encoder.take();
 }
 
 Item &Item::operator=(const Item &item) {
@@ -243,7 +242,7 @@ ItemMaterial mcplus::getItemMaterial(const std::string& itemName) {
 }
 
 static bool checkBelongTo(ItemMaterial start, ItemMaterial end, ItemId id) {
-    return static_cast<ItemId>(start) > id && id < static_cast<ItemId>(end);
+    return static_cast<ItemId>(start) < id && id < static_cast<ItemId>(end);
 }
 
 static std::string getToolLevelName(ItemToolData::Level level) {
@@ -284,14 +283,14 @@ Inventory::Inventory(const std::string &raw) {
 Inventory::Inventory() = default;
 
 std::string Inventory::raw() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{itemList.size() * 24};
 
     if (!itemList.empty()) {
-        ss << itemList[0]->raw();
-        std::for_each(itemList.begin() + 1, itemList.end(), [&ss](const auto& item){ ss << ':' << item->raw(); });
+        encoder << itemList[0]->raw();
+        std::for_each(itemList.begin() + 1, itemList.end(), [&encoder](const auto& item){ encoder << ':' << item->raw(); });
     }
 
-    return ss.str();
+    return encoder.take();
 }
 
 std::size_t Inventory::size() const {
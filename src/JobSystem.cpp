@@ -0,0 +1,149 @@
+#include "JobSystem.h"
+
+using namespace mcplus;
+
+// the pool the current thread works for, and its queue there
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local std::size_t currentQueue = 0;
+
+std::size_t JobSystem::defaultThreadCount() {
+    return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+JobSystem::JobSystem(std::size_t threadCount) {
+    this->queued   = 0;
+    this->stopping = false;
+
+    this->queues.clear();
+    for (std::size_t i = 0; i <= threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    this->threads.clear();
+    for (std::size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&JobSystem::work, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        stopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void JobSystem::work(std::size_t index) {
+    currentSystem = this;
+    currentQueue  = index;
+
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{sleepMutex};
+        workAvailable.wait(lock, [this]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+std::size_t JobSystem::queueOfThisThread() const {
+    return currentSystem == this ? currentQueue : queues.size() - 1;
+}
+
+bool JobSystem::runOne(std::size_t queue) {
+    Work work{nullptr, 0};
+
+    {
+        // newest first from our own queue, it is the work we are waiting on
+        Queue& own = *queues[queue];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.works.empty()) {
+            work = own.works.back();
+            own.works.pop_back();
+        }
+    }
+
+    // oldest first from the others, the biggest pieces are usually there
+    for (std::size_t i = 1; work.batch == nullptr && i < queues.size(); i++) {
+        Queue& victim = *queues[(queue + i) % queues.size()];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.works.empty()) {
+            work = victim.works.front();
+            victim.works.pop_front();
+        }
+    }
+
+    if (work.batch == nullptr) {
+        return false;
+    }
+
+    queued.fetch_sub(1, std::memory_order_acq_rel);
+    execute(work);
+
+    return true;
+}
+
+void JobSystem::execute(const Work& work) {
+    Batch& batch = *work.batch;
+
+    try {
+        (*batch.jobs)[work.index]();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock{batch.failureMutex};
+        if (!batch.failure) {
+            batch.failure = std::current_exception();
+        }
+    }
+
+    // last touch of the batch, run() may return right after
+    batch.remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::run(const std::vector<Job>& jobs) {
+    if (jobs.empty()) {
+        return;
+    }
+
+    Batch batch{};
+    batch.jobs = &jobs;
+    batch.remaining.store(jobs.size(), std::memory_order_relaxed);
+    batch.failure = nullptr;
+
+    std::size_t queue = queueOfThisThread();
+    {
+        Queue& own = *queues[queue];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        // reversed, so popping from the back runs them in order
+        for (std::size_t i = jobs.size(); i-- > 0;) {
+            own.works.push_back(Work{&batch, i});
+        }
+    }
+
+    queued.fetch_add(jobs.size(), std::memory_order_acq_rel);
+    if (!threads.empty()) {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        workAvailable.notify_all();
+    }
+
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if (!runOne(queue)) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (batch.failure) {
+        std::rethrow_exception(batch.failure);
+    }
+}
+
+std::size_t JobSystem::size() const {
+    return threads.size();
+}
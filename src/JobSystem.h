@@ -0,0 +1,107 @@
+#ifndef MINICRAFTSERVER_JOBSYSTEM_H
+#define MINICRAFTSERVER_JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcplus {
+
+    /**
+     * Work-stealing job scheduler shared by the whole tick.
+     *
+     * Every worker has its own deque: it pushes and pops its jobs at the
+     * back and idle workers steal from the front of the others. A thread
+     * waiting in run() keeps running jobs meanwhile, so jobs may run()
+     * more jobs (a world tick splitting its entities) without deadlocking,
+     * and threads from outside the pool help with the batch they submitted.
+     */
+    class JobSystem {
+    public:
+        using Job = std::function<void()>;
+    private:
+        struct Batch {
+            const std::vector<Job>* jobs;
+            std::atomic<std::size_t> remaining;
+
+            std::mutex failureMutex;
+            std::exception_ptr failure;
+        };
+
+        struct Work {
+            Batch* batch;
+            std::size_t index;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Work> works;
+        };
+
+        std::vector<std::thread> threads;
+        // one per worker, the last one takes the jobs of threads outside the pool
+        std::vector<std::unique_ptr<Queue>> queues;
+
+        std::mutex sleepMutex;
+        std::condition_variable workAvailable;
+        std::atomic<std::size_t> queued;
+        bool stopping;
+
+        void work(std::size_t index);
+        [[nodiscard]] std::size_t queueOfThisThread() const;
+        bool runOne(std::size_t queue);
+        static void execute(const Work& work);
+    public:
+        /**
+         * One thread less than the cores, the thread calling run() is the last one.
+         */
+        static std::size_t defaultThreadCount();
+
+        explicit JobSystem(std::size_t threadCount = defaultThreadCount());
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /**
+         * Runs every job and returns once all of them are done. If some
+         * threw, the first exception is rethrown once the rest finished.
+         */
+        void run(const std::vector<Job>& jobs);
+
+        /**
+         * Calls body(begin, end) over [0, count) in slices of grain items.
+         */
+        template<typename F>
+        void parallelFor(std::size_t count, std::size_t grain, F&& body) {
+            grain = std::max<std::size_t>(grain, 1);
+            if (count <= grain || threads.empty()) {
+                body(std::size_t{0}, count);
+                return;
+            }
+
+            std::vector<Job> jobs{};
+            jobs.reserve((count + grain - 1) / grain);
+            for (std::size_t begin = 0; begin < count; begin += grain) {
+                std::size_t end = std::min(begin + grain, count);
+                jobs.emplace_back([&body, begin, end]() {
+                    body(begin, end);
+                });
+            }
+            run(jobs);
+        }
+
+        [[nodiscard]] std::size_t size() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_JOBSYSTEM_H
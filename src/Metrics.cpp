@@ -0,0 +1,217 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using namespace mcplus;
+
+Counter::Counter() {
+    this->value = 0;
+}
+
+std::uint64_t Counter::get() const {
+    return value.load(std::memory_order_relaxed);
+}
+
+Histogram::Histogram() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    this->sum   = 0;
+    this->max   = 0;
+}
+
+std::size_t Histogram::bucketOf(std::uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+
+    // the bits under the top SUB_BUCKET_BITS ones only pick the width of the bucket
+    auto shift = static_cast<std::size_t>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+    std::size_t index = (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>(value >> shift) - SUB_BUCKETS;
+
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+std::uint64_t Histogram::upperBoundOf(std::size_t bucket) {
+    std::size_t group = bucket / SUB_BUCKETS;
+    std::uint64_t sub = bucket % SUB_BUCKETS;
+    if (group == 0) {
+        return sub;
+    }
+
+    return ((SUB_BUCKETS + sub + 1) << (group - 1)) - 1;
+}
+
+void Histogram::record(std::uint64_t value) {
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot{};
+    // counted from the buckets, so a quantile never points past the count
+    snapshot.count = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; i++) {
+        snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.sum = sum.load(std::memory_order_relaxed);
+    snapshot.max = max.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+std::uint64_t Histogram::Snapshot::valueAt(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(upperBoundOf(i), max);
+        }
+    }
+
+    return max;
+}
+
+MetricsRegistry::MetricsRegistry() {
+    this->metrics = {};
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry _registry{};
+    return _registry;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (const auto& metric : metrics) {
+        if (metric.kind == Kind::COUNTER && metric.name == name && metric.labels == labels) {
+            return counters[metric.index];
+        }
+    }
+
+    counters.emplace_back();
+    metrics.push_back({Kind::COUNTER, name, help, labels, counters.size() - 1});
+
+    return counters.back();
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (const auto& metric : metrics) {
+        if (metric.kind == Kind::HISTOGRAM && metric.name == name && metric.labels == labels) {
+            return histograms[metric.index];
+        }
+    }
+
+    histograms.emplace_back();
+    metrics.push_back({Kind::HISTOGRAM, name, help, labels, histograms.size() - 1});
+
+    return histograms.back();
+}
+
+static void writeSample(utils::TextEncoder& encoder, const std::string& name, const std::string& labels,
+                        const std::string& extraLabel, double value) {
+    encoder << name;
+    if (!labels.empty() || !extraLabel.empty()) {
+        encoder << '{' << labels;
+        if (!labels.empty() && !extraLabel.empty()) {
+            encoder << ',';
+        }
+        encoder << extraLabel << '}';
+    }
+    encoder << ' ' << value << '\n';
+}
+
+void MetricsRegistry::writeText(utils::TextEncoder& encoder) const {
+    static constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // every name once, with all its label sets under it
+    std::vector<const Metric*> sorted{};
+    sorted.reserve(metrics.size());
+    for (const auto& metric : metrics) {
+        sorted.push_back(&metric);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Metric* a, const Metric* b) {
+        return a->name < b->name;
+    });
+
+    const std::string* previous = nullptr;
+    for (const Metric* metric : sorted) {
+        if (previous == nullptr || *previous != metric->name) {
+            encoder << "# HELP " << metric->name << ' ' << metric->help << '\n'
+                    << "# TYPE " << metric->name << ' ' << (metric->kind == Kind::COUNTER ? "counter" : "summary") << '\n';
+            previous = &metric->name;
+        }
+
+        if (metric->kind == Kind::COUNTER) {
+            writeSample(encoder, metric->name, metric->labels, "", static_cast<double>(counters[metric->index].get()));
+            continue;
+        }
+
+        auto snapshot = histograms[metric->index].snapshot();
+        for (double quantile : QUANTILES) {
+            utils::TextEncoder label{};
+            label << "quantile=\"" << quantile << '"';
+            writeSample(encoder, metric->name, metric->labels, label.take(), static_cast<double>(snapshot.valueAt(quantile)) / 1e9);
+        }
+        writeSample(encoder, metric->name + "_sum", metric->labels, "", static_cast<double>(snapshot.sum) / 1e9);
+        writeSample(encoder, metric->name + "_count", metric->labels, "", static_cast<double>(snapshot.count));
+    }
+}
+
+PacketMetrics::PacketMetrics() {
+    auto& registry = MetricsRegistry::global();
+
+    auto create = [&registry](const std::string& name) {
+        std::string labels = "type=\"" + name + "\"";
+        return Type{
+                name,
+                &registry.counter("minicraft_packets_received_total", "Packets read from clients.", labels),
+                &registry.counter("minicraft_packet_received_bytes_total", "Bytes of the packets read, framing included.", labels),
+                &registry.counter("minicraft_packets_sent_total", "Packets queued for clients.", labels),
+                &registry.counter("minicraft_packet_sent_bytes_total", "Bytes of the packets queued, framing included.", labels),
+                &registry.counter("minicraft_bad_packets_total", "Packets the handler refused or failed to parse.", labels),
+                &registry.histogram("minicraft_packet_decode_seconds", "Time to cut a frame out of the stream.", labels),
+                &registry.histogram("minicraft_packet_handle_seconds", "Time to parse and handle a packet on the tick.", labels)
+        };
+    };
+
+    // ids outside the protocol share one set of metrics
+    Type unknown = create("UNKNOWN");
+    for (std::size_t id = 0; id < types.size(); id++) {
+        auto type = static_cast<PacketType>(id);
+        std::string name = getPacketName(type);
+        types[id] = name == "UNKNOWN" ? unknown : create(name);
+    }
+
+    this->badFrames = &registry.counter("minicraft_bad_frames_total", "Streams that could not be framed, dropping the connection.");
+}
+
+PacketMetrics& PacketMetrics::global() {
+    static PacketMetrics _metrics{};
+    return _metrics;
+}
+
+const PacketMetrics::Type& PacketMetrics::getType(PacketId id) const {
+    return types[static_cast<std::uint8_t>(id)];
+}
+
+std::uint64_t PacketMetrics::getBadFrames() const {
+    return badFrames->get();
+}
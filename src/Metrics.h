@@ -0,0 +1,190 @@
+#ifndef MINICRAFTSERVER_METRICS_H
+#define MINICRAFTSERVER_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MinicraftDef.h"
+#include "Protocol.h"
+#include "Utils.h"
+
+namespace mcplus {
+
+    class Counter {
+        std::atomic<std::uint64_t> value;
+    public:
+        Counter();
+
+        void add(std::uint64_t amount = 1) {
+            value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint64_t get() const;
+    };
+
+    /**
+     * Log-linear histogram in the spirit of HdrHistogram: every power of two
+     * is split in SUB_BUCKETS linear buckets, so any value lands in a bucket
+     * at most 1/SUB_BUCKETS wider than itself. Recording is a couple of
+     * relaxed atomic adds, safe from any thread.
+     */
+    class Histogram {
+    public:
+        static constexpr std::size_t SUB_BUCKET_BITS = 3;
+        static constexpr std::size_t SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+        // up to 2^40, over 18 minutes in nanoseconds; larger values go in the last bucket
+        static constexpr std::size_t MAX_BITS     = 40;
+        static constexpr std::size_t BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        struct Snapshot {
+            std::uint64_t count;
+            std::uint64_t sum;
+            std::uint64_t max;
+            std::array<std::uint64_t, BUCKET_COUNT> buckets;
+
+            /**
+             * The upper bound of the bucket holding the given quantile, 0 when empty.
+             */
+            [[nodiscard]] std::uint64_t valueAt(double quantile) const;
+        };
+    private:
+        std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets;
+        std::atomic<std::uint64_t> sum;
+        std::atomic<std::uint64_t> max;
+    public:
+        Histogram();
+
+        static std::size_t bucketOf(std::uint64_t value);
+        static std::uint64_t upperBoundOf(std::size_t bucket);
+
+        void record(std::uint64_t value);
+
+        /**
+         * Not atomic as a whole, buckets recorded meanwhile may or may not show.
+         */
+        [[nodiscard]] Snapshot snapshot() const;
+    };
+
+    /**
+     * Every counter and histogram of the server, by name and labels.
+     *
+     * Metrics are created once and never removed, so callers keep the
+     * returned reference and the hot path never looks anything up.
+     */
+    class MetricsRegistry {
+        enum class Kind {
+            COUNTER,
+            HISTOGRAM
+        };
+
+        struct Metric {
+            Kind kind;
+            std::string name;
+            std::string help;
+            std::string labels; // already formatted, like type="MOVE"
+            // histograms are in nanoseconds and exported in seconds
+            std::size_t index;
+        };
+
+        mutable std::mutex mutex;
+        std::deque<Counter> counters;
+        std::deque<Histogram> histograms;
+        std::vector<Metric> metrics;
+
+        MetricsRegistry();
+    public:
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+        static MetricsRegistry& global();
+
+        Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+        Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+        /**
+         * Prometheus text exposition format, histograms as summaries with
+         * their 0.5, 0.9, 0.99 and 0.999 quantiles.
+         */
+        void writeText(utils::TextEncoder& encoder) const;
+    };
+
+    /**
+     * The per-PacketType metrics, indexed by packet id.
+     */
+    class PacketMetrics {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Type {
+            std::string name;
+            Counter* received;
+            Counter* receivedBytes;
+            Counter* sent;
+            Counter* sentBytes;
+            Counter* bad;
+            Histogram* decode;
+            Histogram* handle;
+        };
+    private:
+        // ids are a single byte on the wire
+        std::array<Type, 256> types;
+        Counter* badFrames;
+
+        PacketMetrics();
+    public:
+        PacketMetrics(const PacketMetrics&) = delete;
+        PacketMetrics& operator=(const PacketMetrics&) = delete;
+
+        static PacketMetrics& global();
+
+        static std::uint64_t nanosSince(Clock::time_point start) {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+
+        /**
+         * A frame cut out of the stream, decodeNanos being the framing and copy.
+         */
+        void received(PacketId id, std::size_t bytes, std::uint64_t decodeNanos) {
+            Type& type = types[static_cast<std::uint8_t>(id)];
+            type.received->add();
+            type.receivedBytes->add(bytes);
+            type.decode->record(decodeNanos);
+        }
+
+        /**
+         * Handled by the tick, parsing the payload included.
+         */
+        void handled(PacketId id, std::uint64_t handleNanos, bool accepted) {
+            Type& type = types[static_cast<std::uint8_t>(id)];
+            type.handle->record(handleNanos);
+            if (!accepted) {
+                type.bad->add();
+            }
+        }
+
+        void sent(PacketId id, std::size_t bytes) {
+            Type& type = types[static_cast<std::uint8_t>(id)];
+            type.sent->add();
+            type.sentBytes->add(bytes);
+        }
+
+        /**
+         * A stream that could not be framed, the connection is dropped.
+         */
+        void badFrame() {
+            badFrames->add();
+        }
+
+        [[nodiscard]] const Type& getType(PacketId id) const;
+        [[nodiscard]] std::uint64_t getBadFrames() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_METRICS_H
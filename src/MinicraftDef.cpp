@@ -1,6 +1,5 @@
 #include "MinicraftDef.h"
-#include <cstdlib>
-#include <cstring>
+#include "Utils.h"
 
 mcplus::VersionPack::VersionPack(const std::string &stringVersion) : version(0), major(0), minor(0) {
     *this = stringVersion;
@@ -18,10 +17,9 @@ mcplus::VersionPack& mcplus::VersionPack::operator=(const VersionPack& anotherVe
 
 // x.y.z(-suffix)
 mcplus::VersionPack &mcplus::VersionPack::operator=(const std::string &stringVersion) {
-    char* token = strtok(const_cast<char*>(stringVersion.c_str()), ".");
+    utils::FieldCursor cursor{stringVersion, '.'};
     for (auto* pint : {&this->version, &this->major, &this->minor}) {
-        *pint = strtol(token, nullptr, 10);
-        token = strtok(nullptr, ".");
+        *pint = cursor.nextNumber<int>();
     }
     return *this;
 }
@@ -0,0 +1,121 @@
+#ifndef MINICRAFTSERVER_MPSCQUEUE_H
+#define MINICRAFTSERVER_MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace mcplus {
+
+    /**
+     * Bounded lock-free queue for many producers and a single consumer.
+     *
+     * A ring of cells, each one with a sequence number telling whether it
+     * is free for the producer at that position or filled for the consumer
+     * (Dmitry Vyukov's bounded queue). Producers only race on the tail with
+     * a compare-and-swap, nobody ever waits on a lock, and a full queue
+     * makes push() fail instead of growing.
+     */
+    template<typename T>
+    class MpscQueue {
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        std::size_t mask;
+
+        // apart, so producers and the consumer don't share a cache line
+        alignas(64) std::atomic<std::size_t> tail;
+        alignas(64) std::atomic<std::size_t> head;
+    public:
+        /**
+         * Rounded up to a power of two.
+         */
+        explicit MpscQueue(std::size_t capacity) {
+            std::size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+
+            this->cells = std::make_unique<Cell[]>(size);
+            this->mask  = size - 1;
+            for (std::size_t i = 0; i < size; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            this->tail.store(0, std::memory_order_relaxed);
+            this->head.store(0, std::memory_order_relaxed);
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        /**
+         * Safe from any thread. False when the queue is full.
+         */
+        bool push(T value) {
+            std::size_t position = tail.load(std::memory_order_relaxed);
+            Cell* cell;
+
+            while (true) {
+                cell = &cells[position & mask];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+                if (difference == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = std::move(value);
+            cell->sequence.store(position + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /**
+         * Only from the consumer thread. False when there is nothing to take.
+         */
+        bool pop(T& value) {
+            std::size_t position = head.load(std::memory_order_relaxed);
+            Cell& cell = cells[position & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1) < 0) {
+                return false;
+            }
+
+            value = std::move(cell.value);
+            cell.value = T{};
+            cell.sequence.store(position + mask + 1, std::memory_order_release);
+            head.store(position + 1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        /**
+         * Only a hint while producers are pushing.
+         */
+        [[nodiscard]] std::size_t size() const {
+            std::size_t pushed = tail.load(std::memory_order_relaxed);
+            std::size_t popped = head.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+        [[nodiscard]] std::size_t capacity() const {
+            return mask + 1;
+        }
+    };
+
+}
+
+#endif // MINICRAFTSERVER_MPSCQUEUE_H
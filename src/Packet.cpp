@@ -1,8 +1,9 @@
 #include "Packet.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
-#include <sstream>
 
 #include "Utils.h"
 
@@ -93,15 +94,14 @@ LoginPacket::operator RawPacket() const {
 LoginPacket& LoginPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::LOGIN), raw);
 
-    std::vector<std::string> splitList{};
-    utils::splitString(raw.data, ";", splitList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    if (splitList.size() != 2) {
+    if (cursor.count() != 2) {
         throw std::invalid_argument("Login Raw Packet is not valid!");
     }
 
-    username = splitList[0];
-    version = splitList[1];
+    username = cursor.next();
+    version = std::string{cursor.next()};
 
     return *this;
 }
@@ -135,32 +135,31 @@ GamePacket::GamePacket(const RawPacket& raw) {
 }
 
 GamePacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{mode.size() + 64};
 
-    ss << mode << ';' << time << ';'
-       << gameSpeed << ';' << (pastDay ? "true" : "false") << ';'
-       << score << ';' << playerCount << ';' << awakenPlayer;
+    encoder << mode << ';' << time << ';'
+            << gameSpeed << ';' << (pastDay ? "true" : "false") << ';'
+            << score << ';' << playerCount << ';' << awakenPlayer;
 
-    return RawPacket{static_cast<PacketId>(PacketType::GAME), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::GAME), encoder.take()};
 }
 
 GamePacket& GamePacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::GAME), raw);
 
-    std::vector<std::string> splitList{};
-    utils::splitString(raw.data, ";", splitList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    if (splitList.size() != 7) {
+    if (cursor.count() != 7) {
        throw std::invalid_argument("Game Raw Packet is not valid!");
     }
 
-    this->mode         = splitList[0];
-    this->time         = std::strtol(splitList[1].c_str(), nullptr, 10);
-    this->gameSpeed    = std::stof(splitList[2]);
-    this->pastDay      = splitList[3] == "true";
-    this->score        = std::strtol(splitList[4].c_str(), nullptr, 10);
-    this->playerCount  = std::strtol(splitList[5].c_str(), nullptr, 10);
-    this->awakenPlayer = std::strtol(splitList[6].c_str(), nullptr, 10);
+    this->mode         = cursor.next();
+    this->time         = cursor.nextNumber<int32_t>();
+    this->gameSpeed    = cursor.nextNumber<float>();
+    this->pastDay      = cursor.next() == "true";
+    this->score        = cursor.nextNumber<int32_t>();
+    this->playerCount  = cursor.nextNumber<int32_t>();
+    this->awakenPlayer = cursor.nextNumber<int32_t>();
 
     return *this;
 }
@@ -186,29 +185,28 @@ InitPacket::InitPacket(const RawPacket& raw) {
 }
 
 InitPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << id << ',' << width << ',' << height << ',' << level << ',' << x << ',' << y;
+    encoder << id << ',' << width << ',' << height << ',' << level << ',' << x << ',' << y;
 
-    return RawPacket{static_cast<PacketId>(PacketType::INIT), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::INIT), encoder.take()};
 }
 
 InitPacket& InitPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::INIT), raw);
 
-    std::vector<std::string> splitList{};
-    utils::splitString(raw.data, ",", splitList);
+    utils::FieldCursor cursor{raw.data, ','};
 
-    if (splitList.size() != 6) {
+    if (cursor.count() != 6) {
         throw std::invalid_argument("Init Raw Packet is not valid!");
     }
 
-    this->id     = std::strtol(splitList[0].c_str(), nullptr, 10);
-    this->width  = std::strtol(splitList[1].c_str(), nullptr, 10);
-    this->height = std::strtol(splitList[2].c_str(), nullptr, 10);
-    this->level  = std::strtol(splitList[3].c_str(), nullptr, 10);
-    this->x      = std::strtol(splitList[4].c_str(), nullptr, 10);
-    this->y      = std::strtol(splitList[5].c_str(), nullptr, 10);
+    this->id     = cursor.nextNumber<int32_t>();
+    this->width  = cursor.nextNumber<int32_t>();
+    this->height = cursor.nextNumber<int32_t>();
+    this->level  = cursor.nextNumber<int32_t>();
+    this->x      = cursor.nextNumber<int32_t>();
+    this->y      = cursor.nextNumber<int32_t>();
 
     return *this;
 }
@@ -230,7 +228,7 @@ LoadPacket::operator RawPacket() const {
 LoadPacket& LoadPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::LOAD), raw);
 
-    this->currentLevel = std::strtol(raw.data.c_str(), nullptr, 10);
+    this->currentLevel = utils::parseNumber<int32_t>(raw.data);
 
     return *this;
 }
@@ -246,31 +244,33 @@ TilesPacket::TilesPacket(const RawPacket& raw) {
 }
 
 TilesPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    // "id,data," takes at most 10 bytes
+    utils::TextEncoder encoder{tileList.size() * 10};
 
     if (!tileList.empty()) {
-        ss << tileList[0].id << ',' << (int32_t) tileList[0].data;
-        std::for_each(tileList.begin() + 1, tileList.end(), [&ss](const auto& tile){ ss << ',' << tile.id << ',' << (int32_t) tile.data; });
+        encoder << tileList[0].id << ',' << (int32_t) tileList[0].data;
+        std::for_each(tileList.begin() + 1, tileList.end(), [&encoder](const auto& tile){ encoder << ',' << tile.id << ',' << (int32_t) tile.data; });
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::TILES), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::TILES), encoder.take()};
 }
 
 TilesPacket& TilesPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::TILES), raw);
 
-    std::vector<std::string> idDataList{};
-    utils::splitString(raw.data, ",", idDataList);
-
-    if (idDataList.size() % 2 == 1) {
-        throw std::runtime_error("TilesPacket: data is odd");
-    }
+    utils::FieldCursor cursor{raw.data, ','};
 
     this->tileList.clear();
-    this->tileList.reserve(idDataList.size());
+    // a tile takes at least "0,0," so this is an upper bound
+    this->tileList.reserve(raw.data.size() / 4 + 1);
+
+    while (cursor.hasNext()) {
+        auto id = cursor.nextNumber<TileId>();
+        if (!cursor.hasNext()) {
+            throw std::runtime_error("TilesPacket: data is odd");
+        }
 
-    for (auto it = idDataList.begin(); it != idDataList.end(); it += 2) {
-        this->tileList.emplace_back((TileId) std::strtol(it->c_str(), nullptr, 10), (uint8_t) std::strtol((it + 1)->c_str(), nullptr, 10));
+        this->tileList.emplace_back(id, cursor.nextNumber<uint8_t>());
     }
 
     return *this;
@@ -287,27 +287,26 @@ EntitiesPacket::EntitiesPacket(const RawPacket& raw) {
 }
 
 EntitiesPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{entityList.size() * 32};
 
     if (!entityList.empty()) {
-        ss << entityList[0]->rawUpdate();
-        std::for_each(entityList.begin() + 1, entityList.end(), [&ss](const auto& entity){ ss << ',' << entity->raw(); });
+        encoder << entityList[0]->rawUpdate();
+        std::for_each(entityList.begin() + 1, entityList.end(), [&encoder](const auto& entity){ encoder << ',' << entity->raw(); });
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::ENTITIES), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::ENTITIES), encoder.take()};
 }
 
 EntitiesPacket& EntitiesPacket::operator=(const RawPacket & raw) {
     check_raw(static_cast<PacketId>(PacketType::ENTITIES), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ",", dataList);
+    utils::FieldCursor cursor{raw.data, ','};
 
     this->entityList.clear();
-    this->entityList.reserve(dataList.size());
+    this->entityList.reserve(cursor.count());
 
-    for (auto it = dataList.begin(); it != dataList.end(); it++) {
-        this->entityList.emplace_back(createEntity(*it));
+    while (cursor.hasNext()) {
+        this->entityList.emplace_back(createEntity(std::string{cursor.next()}));
     }
 
     return *this;
@@ -328,22 +327,23 @@ TilePacket::TilePacket(const RawPacket& raw) {
 }
 
 TilePacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << world << ';' << position << ';' << tile.id << ';' << tile.data;
+    encoder << world << ';' << position << ';' << tile.id << ';' << tile.data;
 
-    return RawPacket{static_cast<PacketId>(PacketType::TILE), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::TILE), encoder.take()};
 }
 
 TilePacket& TilePacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::TILE), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->world = strtol(dataList[0].c_str(), nullptr, 10);
-    this->position = strtol(dataList[1].c_str(), nullptr, 10);
-    this->tile = Tile{static_cast<TileId>(strtol(dataList[2].c_str(), nullptr, 10)), (uint8_t) strtol(dataList[3].c_str(), nullptr, 10)};
+    this->world    = cursor.nextNumber<WorldId>();
+    this->position = cursor.nextNumber<int32_t>();
+
+    auto id = cursor.nextNumber<TileId>();
+    this->tile = Tile{id, cursor.nextNumber<uint8_t>()};
 
     return *this;
 }
@@ -352,6 +352,10 @@ EntityPacket::EntityPacket(const Entity& entity) {
     this->entity = entity.get();
 }
 
+EntityPacket::EntityPacket(std::shared_ptr<Entity> entity) {
+    this->entity = std::move(entity);
+}
+
 EntityPacket::EntityPacket(const RawPacket& raw) {
     this->entity = {};
 
@@ -433,84 +437,89 @@ PlayerPacket::PlayerPacket(const RawPacket &raw) {
 }
 
 PlayerPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{256 + inventory.size() * 24};
 
-    ss << (std::string) version << '\n';
+    encoder << (std::string) version << '\n';
 
-    ss << x << ',' << y << ','
-       << spawnX << ',' << spawnY << ','
-       << health << ',' << hunger << ','
-       << armor << ',' << armorDamageBuffer << ',' << getItemName(curArmor) << ','
-       << score << ',' << level;
+    encoder << x << ',' << y << ','
+            << spawnX << ',' << spawnY << ','
+            << health << ',' << hunger << ','
+            << armor << ',' << armorDamageBuffer << ',' << getItemName(curArmor) << ','
+            << score << ',' << level;
 
-    ss << ",PotionEffects[";
+    encoder << ",PotionEffects[";
     if (potionList.empty()) {
-        ss << ']';
+        encoder << ']';
     } else {
-        ss << getPotionName(potionList[0].type) << ';' << potionList[0].duration;
-        std::for_each(potionList.begin() + 1, potionList.end(), [&ss](const auto& potion){ ss << ':' << getPotionName(potion.type) << ';' << potion.duration; });
+        encoder << getPotionName(potionList[0].type) << ';' << potionList[0].duration;
+        std::for_each(potionList.begin() + 1, potionList.end(), [&encoder](const auto& potion){ encoder << ':' << getPotionName(potion.type) << ';' << potion.duration; });
     }
-    ss << ',';
-    ss << shirtColor.raw() << ',' << (skinon ? "true" : "false");
+    encoder << ',';
+    encoder << shirtColor.raw() << ',' << (skinon ? "true" : "false");
 
-    ss << '\n';
+    encoder << '\n';
 
     if (inventory.empty()) {
-        ss << "NULL";
+        encoder << "NULL";
     } else {
-        ss << inventory[0].raw();
-        std::for_each(inventory.begin() + 1, inventory.end(), [&ss](const auto& item) { ss << ',' << item.raw(); });
+        encoder << inventory[0].raw();
+        std::for_each(inventory.begin() + 1, inventory.end(), [&encoder](const auto& item) { encoder << ',' << item.raw(); });
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::PLAYER), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::PLAYER), encoder.take()};
 }
 
 PlayerPacket& PlayerPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::PLAYER), raw);
 
-    std::vector<std::string> globalList{};
-    utils::splitString(raw.data, "\n", globalList);
+    utils::FieldCursor globalCursor{raw.data, '\n'};
 
-    this->version = globalList[0];
+    if (globalCursor.count() != 3) {
+        throw std::invalid_argument("Player Raw Packet is not valid!");
+    }
+
+    this->version = std::string{globalCursor.next()};
+
+    utils::FieldCursor statCursor{globalCursor.next(), ','};
 
-    std::vector<std::string> statList{};
-    utils::splitString(globalList[1], ",", statList);
+    this->x                 = statCursor.nextNumber<int32_t>();
+    this->y                 = statCursor.nextNumber<int32_t>();
+    this->spawnX            = statCursor.nextNumber<int32_t>();
+    this->spawnY            = statCursor.nextNumber<int32_t>();
+    this->health            = statCursor.nextNumber<int32_t>();
+    this->hunger            = statCursor.nextNumber<int32_t>();
+    this->armor             = statCursor.nextNumber<int32_t>();
+    this->armorDamageBuffer = statCursor.nextNumber<int32_t>();
+    this->curArmor          = getItemMaterial(std::string{statCursor.next()});
+    this->score             = statCursor.nextNumber<int32_t>();
+    this->level             = statCursor.nextNumber<int32_t>();
 
-    this->x                 = std::strtol(statList[0].c_str(), nullptr, 10);
-    this->y                 = std::strtol(statList[1].c_str(), nullptr, 10);
-    this->spawnX            = std::strtol(statList[2].c_str(), nullptr, 10);
-    this->spawnY            = std::strtol(statList[3].c_str(), nullptr, 10);
-    this->health            = std::strtol(statList[4].c_str(), nullptr, 10);
-    this->hunger            = std::strtol(statList[5].c_str(), nullptr, 10);
-    this->armor             = std::strtol(statList[6].c_str(), nullptr, 10);
-    this->armorDamageBuffer = std::strtol(statList[7].c_str(), nullptr, 10);
-    this->curArmor          = getItemMaterial(statList[8]);
-    this->score             = std::strtol(statList[9].c_str(), nullptr, 10);
-    this->level             = std::strtol(statList[10].c_str(), nullptr, 10);
+    // PotionEffects[name;duration:name;duration]
+    std::string_view potionEffects = statCursor.next();
+    potionEffects.remove_prefix(std::min<std::size_t>(potionEffects.find('[') + 1, potionEffects.size()));
+    potionEffects = potionEffects.substr(0, potionEffects.find(']'));
 
-    std::vector<std::string> potionDataList{};
-    utils::splitString(statList[11].substr(14, statList[11].size() - 1), ":", potionDataList);
+    utils::FieldCursor potionCursor{potionEffects, ':'};
     this->potionList.clear();
-    this->potionList.reserve(potionDataList.size());
-    for (const auto& potionData : potionDataList) {
-        std::vector<std::string> rawPotion{};
-        rawPotion.reserve(2);
-        utils::splitString(potionData, ";", rawPotion);
+    while (potionCursor.hasNext()) {
+        utils::FieldCursor rawPotion{potionCursor.next(), ';'};
 
-        this->potionList.emplace_back(getPotionType(rawPotion[0]), (int32_t) std::strtol(rawPotion[1].c_str(), nullptr, 10));
+        auto type = getPotionType(std::string{rawPotion.next()});
+        this->potionList.emplace_back(type, rawPotion.nextNumber<int32_t>());
     }
 
-    this->shirtColor        = Color{(int32_t) std::strtol(statList[12].c_str(), nullptr, 10)};
-    this->skinon            = statList[13] == "true";
+    this->shirtColor        = Color{statCursor.nextNumber<int32_t>()};
+    this->skinon            = statCursor.next() == "true";
 
-    std::vector<std::string> itemList{};
-    utils::splitString(globalList[2], ",", itemList);
+    utils::FieldCursor itemCursor{globalCursor.next(), ','};
 
     this->inventory.clear();
-    this->inventory.reserve(itemList.size());
+    if (itemCursor.remaining() != "NULL") {
+        this->inventory.reserve(itemCursor.count());
 
-    for (auto it = itemList.begin(); it != itemList.end(); it += 2) {
-        this->inventory.emplace_back(static_cast<ItemId>(std::strtol(it->c_str(), nullptr, 10), (uint8_t) std::strtol((it + 1)->c_str(), nullptr, 10)));
+        while (itemCursor.hasNext()) {
+            this->inventory.emplace_back(std::string{itemCursor.next()});
+        }
     }
 
     return *this;
@@ -531,22 +540,21 @@ MovePacket::MovePacket(const RawPacket& raw) {
 }
 
 MovePacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << (location.x << 4 | location.xDecimal) << ';' << (location.y << 4 | location.yDecimal) << ';'
-       << static_cast<uint8_t>(direction) << ';' << world;
+    encoder << (location.x << 4 | location.xDecimal) << ';' << (location.y << 4 | location.yDecimal) << ';'
+            << static_cast<uint8_t>(direction) << ';' << world;
 
-    return RawPacket{static_cast<PacketId>(PacketType::MOVE), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::MOVE), encoder.take()};
 }
 
 MovePacket& MovePacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::MOVE), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    int32_t _x = std::strtol(dataList[0].c_str(), nullptr, 10);
-    int32_t _y = std::strtol(dataList[1].c_str(), nullptr, 10);
+    auto _x = cursor.nextNumber<int32_t>();
+    auto _y = cursor.nextNumber<int32_t>();
 
     this->location.x        = _x >> 4;
     this->location.xDecimal = _x & 0xF;
@@ -554,9 +562,8 @@ MovePacket& MovePacket::operator=(const RawPacket& raw) {
     this->location.y        = _y >> 4;
     this->location.yDecimal = _y & 0xF;
 
-    this->direction = static_cast<Direction>(std::strtol(dataList[2].c_str(), nullptr, 10));
-    this->world     = std::strtol(dataList[3].c_str(), nullptr, 10);
-
+    this->direction = static_cast<Direction>(cursor.nextNumber<int32_t>());
+    this->world     = cursor.nextNumber<WorldId>();
 
     return *this;
 }
@@ -565,6 +572,10 @@ AddPacket::AddPacket(const Entity& entity) {
     this->entity = entity.get();
 }
 
+AddPacket::AddPacket(std::shared_ptr<Entity> entity) {
+    this->entity = std::move(entity);
+}
+
 AddPacket::AddPacket(const RawPacket& raw) {
     this->entity = {};
 
@@ -596,29 +607,28 @@ RemovePacket::RemovePacket(const RawPacket& raw) {
 }
 
 RemovePacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << entity;
+    encoder << entity;
     if (world.has_value()) {
-        ss << ';' << world.value();
+        encoder << ';' << world.value();
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::REMOVE), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::REMOVE), encoder.take()};
 }
 
 RemovePacket& RemovePacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::REMOVE), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    std::size_t size = dataList.size();
+    std::size_t size = cursor.count();
     if (size == 1) {
-        this->entity = strtol(dataList[0].c_str(), nullptr, 10);
+        this->entity = cursor.nextNumber<EntityId>();
         this->world = std::optional<WorldId>();
     } else if (size == 2) {
-        this->entity = strtol(dataList[0].c_str(), nullptr, 10);
-        this->world = strtol(dataList[1].c_str(), nullptr, 10);
+        this->entity = cursor.nextNumber<EntityId>();
+        this->world = cursor.nextNumber<WorldId>();
     } else {
         throw std::runtime_error("RemovePacket: invalid data: " + raw.data);
     }
@@ -669,21 +679,20 @@ NotifyPacket::NotifyPacket(const RawPacket& raw) {
 }
 
 NotifyPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{note.size() + 16};
 
-    ss << notetime << ';' << note;
+    encoder << notetime << ';' << note;
 
-    return RawPacket{static_cast<PacketId>(PacketType::NOTIFY), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::NOTIFY), encoder.take()};
 }
 
 NotifyPacket& NotifyPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::NOTIFY), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->notetime = strtol(dataList[0].c_str(), nullptr, 10);
-    this->note     = dataList[1];
+    this->notetime = cursor.nextNumber<int32_t>();
+    this->note     = cursor.next();
 
     return *this;
 }
@@ -715,31 +724,30 @@ InteractPacket::InteractPacket(const RawPacket& raw) {
 }
 
 InteractPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << item.raw();
+    encoder << item.raw();
 
     if (!isOutgoing) {
-        ss << ';' << stamina << ';' << arrowCount;
+        encoder << ';' << stamina << ';' << arrowCount;
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::INTERACT), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::INTERACT), encoder.take()};
 }
 
 InteractPacket& InteractPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::INTERACT), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->item       = Item{dataList[0]};
+    std::size_t size = cursor.count();
+    this->item       = Item{std::string{cursor.next()}};
 
-    std::size_t size = dataList.size();
     if (size == 1) {
         this->isOutgoing = true;
     } else if (size == 3) {
-        this->stamina    = std::strtol(dataList[1].c_str(), nullptr, 10);
-        this->arrowCount = std::strtol(dataList[2].c_str(), nullptr, 10);
+        this->stamina    = cursor.nextNumber<int32_t>();
+        this->arrowCount = cursor.nextNumber<int32_t>();
         this->isOutgoing = false;
     } else {
         throw std::runtime_error("InteractPacket: invalid data: " + raw.data);
@@ -765,7 +773,7 @@ PushPacket::operator RawPacket() const {
 PushPacket& PushPacket::operator=(const RawPacket &raw) {
     check_raw(static_cast<PacketId>(PacketType::PUSH), raw);
 
-    this->entity = std::strtol(raw.data.c_str(), nullptr, 10);
+    this->entity = utils::parseNumber<EntityId>(raw.data);
 
     return *this;
 }
@@ -787,7 +795,7 @@ PickupPacket::operator RawPacket() const {
 PickupPacket& PickupPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::PICKUP), raw);
 
-    this->entity = std::strtol(raw.data.c_str(), nullptr, 10);
+    this->entity = utils::parseNumber<EntityId>(raw.data);
 
     return *this;
 }
@@ -807,22 +815,21 @@ ChestInPacket::ChestInPacket(const RawPacket& raw) {
 }
 
 ChestInPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
-    ss << chestId << ';' << index << ';' << item.raw();
+    encoder << chestId << ';' << index << ';' << item.raw();
 
-    return RawPacket{static_cast<PacketId>(PacketType::CHEST_IN), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::CHEST_IN), encoder.take()};
 }
 
 ChestInPacket& ChestInPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::CHEST_IN), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->chestId = std::strtol(dataList[0].c_str(), nullptr, 10);
-    this->index   = std::strtol(dataList[1].c_str(), nullptr, 10);
-    this->item    = Item{dataList[2]};
+    this->chestId = cursor.nextNumber<EntityId>();
+    this->index   = cursor.nextNumber<int32_t>();
+    this->item    = Item{std::string{cursor.next()}};
 
     return *this;
 }
@@ -840,44 +847,43 @@ ChestOutPacket::ChestOutPacket(const RawPacket& raw) {
 }
 
 ChestOutPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{};
 
     /*if (data.type == Type::IN) {
         const ChestOutPacket::InPacket& inputData = *this->data.in;
         
-        ss << inputData.chestId << ';' << inputData.itemIndex << ';' << (inputData.wholeStack ? "true" : "false") << inputData.inputIndex;
+        encoder << inputData.chestId << ';' << inputData.itemIndex << ';' << (inputData.wholeStack ? "true" : "false") << inputData.inputIndex;
     } else if (data.type == Type::OUT) {
         const ChestOutPacket::OutPacket& outputData = *this->data.out;
 
-        ss << outputData.item.raw() << ';' << outputData.index;
+        encoder << outputData.item.raw() << ';' << outputData.index;
     }*/
 
-    return RawPacket{static_cast<PacketId>(PacketType::CHEST_OUT), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::CHEST_OUT), encoder.take()};
 }
 
 ChestOutPacket& ChestOutPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::CHEST_OUT), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    /*std::size_t size = dataList.size();
+    /*std::size_t size = cursor.count();
     if (size == 1 || size == 4) {
         _data->type = Data::Type::IN;
         ChestOutPacket::InPacket& inputData = this->_data->in;
 
-        inputData.chestId        = std::strtol(dataList[0].c_str(), nullptr, 10);
+        inputData.chestId        = cursor.nextNumber<EntityId>();
         if (size == 4) {
-            inputData.itemIndex  = std::strtol(dataList[1].c_str(), nullptr, 10);
-            inputData.wholeStack = dataList[2] == "true";
-            inputData.inputIndex = std::strtol(dataList[3].c_str(), nullptr, 10);
+            inputData.itemIndex  = cursor.nextNumber<int32_t>();
+            inputData.wholeStack = cursor.next() == "true";
+            inputData.inputIndex = cursor.nextNumber<int32_t>();
         }
     } else if (size == 2) {
         _data->type = Data::Type::OUT;
         ChestOutPacket::OutPacket& outputData = this->_data->out;
 
-        outputData.item  = Item{dataList[0]};
-        outputData.index = std::strtol(dataList[1].c_str(), nullptr, 10);
+        outputData.item  = Item{std::string{cursor.next()}};
+        outputData.index = cursor.nextNumber<int32_t>();
     }*/
 
     return *this;
@@ -894,27 +900,26 @@ AddItemsPacket::AddItemsPacket(const RawPacket& raw) {
 }
 
 AddItemsPacket::operator RawPacket() const {
-    std::stringstream ss{};
+    utils::TextEncoder encoder{itemList.size() * 24};
 
     if (!itemList.empty()) {
-        ss << itemList[0].raw();
-        std::for_each(itemList.begin(), itemList.end(), [&ss](const auto& item){ ss << ';' << item.raw(); });
+        encoder << itemList[0].raw();
+        std::for_each(itemList.begin(), itemList.end(), [&encoder](const auto& item){ encoder << ';' << item.raw(); });
     }
 
-    return RawPacket{static_cast<PacketId>(PacketType::ADD_ITEMS), ss.str()};
+    return RawPacket{static_cast<PacketId>(PacketType::ADD_ITEMS), encoder.take()};
 }
 
 AddItemsPacket& AddItemsPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::ADD_ITEMS), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
     this->itemList.clear();
-    this->itemList.reserve(dataList.size());
+    this->itemList.reserve(cursor.count());
 
-    for (const auto& rawItem : dataList) {
-        this->itemList.emplace_back(rawItem);
+    while (cursor.hasNext()) {
+        this->itemList.emplace_back(std::string{cursor.next()});
     }
 
     return *this;
@@ -939,11 +944,10 @@ BedPacket::operator RawPacket() const {
 BedPacket& BedPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::BED), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->enabled = dataList[0] == "true";
-    this->bedId   = dataList.size() > 1 ? std::strtol(dataList[1].c_str(), nullptr, 10) : 0;
+    this->enabled = cursor.next() == "true";
+    this->bedId   = cursor.hasNext() ? cursor.nextNumber<EntityId>() : 0;
 
     return *this;
 }
@@ -969,12 +973,11 @@ HurtPacket::operator RawPacket() const {
 HurtPacket& HurtPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::HURT), raw);
 
-    std::vector<std::string> dataList{};
-    utils::splitString(raw.data, ";", dataList);
+    utils::FieldCursor cursor{raw.data, ';'};
 
-    this->entity    = std::strtol(dataList[0].c_str(), nullptr, 10);
-    this->damage    = std::strtol(dataList[1].c_str(), nullptr, 10);
-    this->direction = static_cast<Direction>(std::strtol(dataList[2].c_str(), nullptr, 10));
+    this->entity    = cursor.nextNumber<EntityId>();
+    this->damage    = cursor.nextNumber<int32_t>();
+    this->direction = static_cast<Direction>(cursor.nextNumber<int32_t>());
 
     return *this;
 }
@@ -1050,7 +1053,7 @@ StaminaPacket::operator RawPacket() const {
 StaminaPacket& StaminaPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::STAMINA), raw);
 
-    this->stamina = std::strtol(raw.data.c_str(), nullptr, 10);
+    this->stamina = utils::parseNumber<int32_t>(raw.data);
 
     return *this;
 }
@@ -1072,7 +1075,7 @@ ShirtPacket::operator RawPacket() const {
 ShirtPacket& ShirtPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::SHIRT), raw);
 
-    this->color = Color{(int32_t) std::strtol(raw.data.c_str(), nullptr, 10)};
+    this->color = Color{utils::parseNumber<int32_t>(raw.data)};
 
     return *this;
 }
@@ -1094,7 +1097,227 @@ StopFishingPacket::operator RawPacket() const {
 StopFishingPacket& StopFishingPacket::operator=(const RawPacket& raw) {
     check_raw(static_cast<PacketId>(PacketType::STOPFISHING), raw);
 
-    this->entity = std::strtol(raw.data.c_str(), nullptr, 10);
+    this->entity = utils::parseNumber<EntityId>(raw.data);
+
+    return *this;
+}
+
+ExtensionsPacket::ExtensionsPacket(const std::vector<Extension>& extensionList) {
+    this->extensionList = extensionList;
+}
+
+ExtensionsPacket::ExtensionsPacket(const RawPacket& raw) {
+    this->extensionList = {};
+
+    *this = raw;
+}
+
+ExtensionsPacket::operator RawPacket() const {
+    utils::TextEncoder encoder{};
+
+    for (std::size_t i = 0; i < extensionList.size(); i++) {
+        if (i != 0) {
+            encoder << ',';
+        }
+        encoder << getExtensionName(extensionList[i]);
+    }
+
+    return RawPacket{static_cast<PacketId>(PacketType::EXTENSIONS), encoder.take()};
+}
+
+ExtensionsPacket& ExtensionsPacket::operator=(const RawPacket& raw) {
+    check_raw(static_cast<PacketId>(PacketType::EXTENSIONS), raw);
+
+    utils::FieldCursor cursor{raw.data, ','};
+
+    this->extensionList.clear();
+    while (cursor.hasNext()) {
+        // newer clients may know extensions we don't, those are just ignored
+        Extension extension = getExtension(std::string{cursor.next()});
+        if (extension != Extension::NONE) {
+            this->extensionList.push_back(extension);
+        }
+    }
+
+    return *this;
+}
+
+static void writeUint16(std::string& buffer, uint16_t value) {
+    buffer.push_back(static_cast<char>(value & 0xFF));
+    buffer.push_back(static_cast<char>(value >> 8));
+}
+
+static void writeUint32(std::string& buffer, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static void writeVarint(std::string& buffer, uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+class BinaryReader {
+    std::string_view rest;
+
+    void require(std::size_t count) const {
+        if (rest.size() < count) {
+            throw std::runtime_error("BinaryTilesPacket: data is truncated");
+        }
+    }
+public:
+    explicit BinaryReader(std::string_view data) : rest(data) {}
+
+    uint8_t readUint8() {
+        require(1);
+        auto value = static_cast<uint8_t>(rest[0]);
+        rest.remove_prefix(1);
+        return value;
+    }
+
+    uint16_t readUint16() {
+        require(2);
+        auto value = static_cast<uint16_t>(static_cast<uint8_t>(rest[0]) | static_cast<uint8_t>(rest[1]) << 8);
+        rest.remove_prefix(2);
+        return value;
+    }
+
+    uint32_t readUint32() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            value |= static_cast<uint32_t>(readUint8()) << shift;
+        }
+        return value;
+    }
+
+    uint32_t readVarint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = readUint8();
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("BinaryTilesPacket: varint is too long");
+    }
+
+    [[nodiscard]] std::size_t remaining() const {
+        return rest.size();
+    }
+};
+
+BinaryTilesPacket::BinaryTilesPacket(const std::vector<Tile>& tileList, TileEncoding encoding) {
+    this->encoding = encoding;
+    this->tileList = tileList;
+}
+
+BinaryTilesPacket::BinaryTilesPacket(const RawPacket& raw) {
+    this->encoding = TileEncoding::RAW;
+    this->tileList = {};
+
+    *this = raw;
+}
+
+BinaryTilesPacket::operator RawPacket() const {
+    std::string buffer{};
+    buffer.reserve(5 + tileList.size() * 3);
+
+    buffer.push_back(static_cast<char>(encoding));
+    writeUint32(buffer, static_cast<uint32_t>(tileList.size()));
+
+    if (encoding == TileEncoding::RAW) {
+        for (const auto& tile : tileList) {
+            writeUint16(buffer, tile.id);
+        }
+        for (const auto& tile : tileList) {
+            buffer.push_back(static_cast<char>(tile.data));
+        }
+    } else if (encoding == TileEncoding::RLE) {
+        for (std::size_t start = 0; start < tileList.size();) {
+            std::size_t end = start + 1;
+            while (end < tileList.size() && tileList[end] == tileList[start]) {
+                end++;
+            }
+
+            writeVarint(buffer, static_cast<uint32_t>(end - start));
+            writeUint16(buffer, tileList[start].id);
+            buffer.push_back(static_cast<char>(tileList[start].data));
+            start = end;
+        }
+    } else {
+        throw std::runtime_error("Tile Encoding missed");
+    }
+
+    return RawPacket{static_cast<PacketId>(PacketType::BINARY_TILES), utils::cobsEncode(buffer)};
+}
+
+BinaryTilesPacket& BinaryTilesPacket::operator=(const RawPacket& raw) {
+    check_raw(static_cast<PacketId>(PacketType::BINARY_TILES), raw);
+
+    std::string buffer = utils::cobsDecode(raw.data);
+    BinaryReader reader{buffer};
+
+    this->encoding = static_cast<TileEncoding>(reader.readUint8());
+    uint32_t count = reader.readUint32();
+    // a 4096x4096 world, far above anything Minicraft+ generates
+    if (count > (1u << 24)) {
+        throw std::runtime_error("BinaryTilesPacket: too many tiles");
+    }
+
+    this->tileList.clear();
+    if (this->encoding == TileEncoding::RAW) {
+        if (reader.remaining() != static_cast<std::size_t>(count) * 3) {
+            throw std::runtime_error("BinaryTilesPacket: tile count doesn't match");
+        }
+
+        this->tileList.resize(count);
+        for (auto& tile : this->tileList) {
+            tile.id = reader.readUint16();
+        }
+        for (auto& tile : this->tileList) {
+            tile.data = reader.readUint8();
+        }
+    } else if (this->encoding == TileEncoding::RLE) {
+        this->tileList.reserve(count);
+
+        while (this->tileList.size() < count) {
+            uint32_t length = reader.readVarint();
+            TileId id = reader.readUint16();
+            uint8_t data = reader.readUint8();
+
+            if (length == 0 || length > count - this->tileList.size()) {
+                throw std::runtime_error("BinaryTilesPacket: run doesn't fit the tile count");
+            }
+            this->tileList.insert(this->tileList.end(), length, Tile{id, data});
+        }
+    } else {
+        throw std::runtime_error("BinaryTilesPacket: unknown tile encoding");
+    }
 
     return *this;
 }
+
+std::string mcplus::getExtensionName(Extension extension) {
+    switch (extension) {
+        case Extension::NONE:
+            return "none";
+        case Extension::BINARY_TILES:
+            return "binary_tiles";
+    }
+
+    return "none";
+}
+
+Extension mcplus::getExtension(const std::string& extensionName) {
+    static std::unordered_map<std::string, Extension> _data{
+            {"binary_tiles", Extension::BINARY_TILES}
+    };
+
+    auto it = _data.find(extensionName);
+    return it != _data.end() ? it->second : Extension::NONE;
+}
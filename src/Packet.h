@@ -188,6 +188,38 @@ namespace mcplus {
 
     // Start Extension
 
+    /**
+     * Protocol additions a player can opt into, legacy clients never do
+     */
+    enum class Extension : uint32_t {
+        NONE         = 0,
+        BINARY_TILES = 1 << 0
+    };
+
+    /**
+     * How a BinaryTilesPacket lays out its tiles
+     */
+    enum class TileEncoding : uint8_t {
+        RAW = 0, // every id as u16, then every data as u8
+        RLE = 1  // runs of (varint length, u16 id, u8 data)
+    };
+
+    /**
+     * Type: Input/Output
+     * Description: Player sends the extensions it understands, server replies
+     *              with the ones it enabled for that connection
+     */
+    struct ExtensionsPacket;
+    /**
+     * Type: Output
+     * Description: Same as TilesPacket but little endian binary, COBS-stuffed
+     *              so it still fits in a null-terminated frame
+     */
+    struct BinaryTilesPacket;
+
+    std::string getExtensionName(Extension extension);
+    Extension getExtension(const std::string& extensionName);
+
     // End Extension
 
     /**
@@ -315,6 +347,7 @@ namespace mcplus {
         std::shared_ptr<Entity> entity;
 
         explicit EntityPacket(const Entity& entity);
+        explicit EntityPacket(std::shared_ptr<Entity> entity);
         explicit EntityPacket(const RawPacket& raw);
 
         explicit operator RawPacket() const override;
@@ -381,6 +414,7 @@ namespace mcplus {
         std::shared_ptr<Entity> entity;
 
         explicit AddPacket(const Entity& entity);
+        explicit AddPacket(std::shared_ptr<Entity> entity);
         explicit AddPacket(const RawPacket& raw);
 
         explicit operator RawPacket() const override;
@@ -609,6 +643,27 @@ namespace mcplus {
         StopFishingPacket& operator=(const RawPacket& raw) override;
     };
 
+    struct ExtensionsPacket : Packet {
+        std::vector<Extension> extensionList;
+
+        explicit ExtensionsPacket(const std::vector<Extension>& extensionList);
+        explicit ExtensionsPacket(const RawPacket& raw);
+
+        explicit operator RawPacket() const override;
+        ExtensionsPacket& operator=(const RawPacket& raw) override;
+    };
+
+    struct BinaryTilesPacket : Packet {
+        TileEncoding encoding;
+        std::vector<Tile> tileList;
+
+        explicit BinaryTilesPacket(const std::vector<Tile>& tileList, TileEncoding encoding = TileEncoding::RLE);
+        explicit BinaryTilesPacket(const RawPacket& raw);
+
+        explicit operator RawPacket() const override;
+        BinaryTilesPacket& operator=(const RawPacket& raw) override;
+    };
+
 }
 
 #endif // MCPLUS_PACKET_HEADER
@@ -1,12 +1,66 @@
 #include "Protocol.h"
+#include "Metrics.h"
+
+#include <unordered_map>
+#include <utility>
 
 using namespace mcplus;
 
 void mcplus::writePacket(utils::Socket& socket, const Packet& packet) {
-    RawPacket rawPacket = (RawPacket) packet;
+    queuePacket(socket, packet);
+    socket.flush();
+}
+
+void mcplus::queuePacket(utils::Socket& socket, const Packet& packet) {
+    queuePacket(socket, (RawPacket) packet);
+}
+
+void mcplus::queuePacket(utils::Socket& socket, RawPacket rawPacket) {
+    PacketMetrics::global().sent(rawPacket.id, rawPacket.data.size() + 2);
+    socket.enqueue(static_cast<std::uint8_t>(rawPacket.id), std::move(rawPacket.data));
+}
+
+std::string mcplus::getPacketName(PacketType packetType) {
+    static std::unordered_map<PacketType, std::string> _data{
+            {PacketType::INVALID,      "INVALID"},
+            {PacketType::PING,         "PING"},
+            {PacketType::USERNAMES,    "USERNAMES"},
+            {PacketType::LOGIN,        "LOGIN"},
+            {PacketType::GAME,         "GAME"},
+            {PacketType::INIT,         "INIT"},
+            {PacketType::LOAD,         "LOAD"},
+            {PacketType::TILES,        "TILES"},
+            {PacketType::ENTITIES,     "ENTITIES"},
+            {PacketType::TILE,         "TILE"},
+            {PacketType::ENTITY,       "ENTITY"},
+            {PacketType::PLAYER,       "PLAYER"},
+            {PacketType::MOVE,         "MOVE"},
+            {PacketType::ADD,          "ADD"},
+            {PacketType::REMOVE,       "REMOVE"},
+            {PacketType::DISCONNECT,   "DISCONNECT"},
+            {PacketType::SAVE,         "SAVE"},
+            {PacketType::NOTIFY,       "NOTIFY"},
+            {PacketType::INTERACT,     "INTERACT"},
+            {PacketType::PUSH,         "PUSH"},
+            {PacketType::PICKUP,       "PICKUP"},
+            {PacketType::CHEST_IN,     "CHEST_IN"},
+            {PacketType::CHEST_OUT,    "CHEST_OUT"},
+            {PacketType::ADD_ITEMS,    "ADD_ITEMS"},
+            {PacketType::BED,          "BED"},
+            {PacketType::POTION,       "POTION"},
+            {PacketType::HURT,         "HURT"},
+            {PacketType::DIE,          "DIE"},
+            {PacketType::RESPAWN,      "RESPAWN"},
+            {PacketType::DROP,         "DROP"},
+            {PacketType::STAMINA,      "STAMINA"},
+            {PacketType::SHIRT,        "SHIRT"},
+            {PacketType::STOPFISHING,  "STOPFISHING"},
+            {PacketType::EXTENSIONS,   "EXTENSIONS"},
+            {PacketType::BINARY_TILES, "BINARY_TILES"}
+    };
 
-    socket.write(rawPacket.id);
-    utils::writeLegacyString(socket, rawPacket.data);
+    auto it = _data.find(packetType);
+    return it != _data.end() ? it->second : "UNKNOWN";
 }
 
 RawPacket mcplus::readPacket(utils::Socket& socket) {
@@ -44,7 +44,11 @@ namespace mcplus {
         DROP        = 0x1E,
         STAMINA     = 0x1F,
         SHIRT       = 0x20,
-        STOPFISHING = 0x21
+        STOPFISHING = 0x21,
+
+        // extensions, never sent to a client that didn't ask for them
+        EXTENSIONS   = 0x40,
+        BINARY_TILES = 0x41
     };
 
     struct RawPacket {
@@ -57,9 +61,22 @@ namespace mcplus {
         virtual Packet& operator=(const RawPacket& raw) = 0;
     };
 
+    /**
+     * The enum name, like "MOVE", or "UNKNOWN" for ids outside the protocol.
+     */
+    std::string getPacketName(PacketType packetType);
+
     using PacketHandler = std::function<bool(utils::Socket&, const RawPacket&)>;
 
+    /**
+     * Sends the packet right away, after anything already queued on that socket.
+     */
     void writePacket(utils::Socket& socket, const Packet& packet);
+    /**
+     * Queues the packet, it's sent with the rest of the tick by the next flush.
+     */
+    void queuePacket(utils::Socket& socket, const Packet& packet);
+    void queuePacket(utils::Socket& socket, RawPacket rawPacket);
     RawPacket readPacket(utils::Socket& socket);
 
 }
@@ -0,0 +1,223 @@
+#include "Reactor.h"
+#include "Utils.h"
+#include "Metrics.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+using namespace mcplus;
+
+static constexpr int MAX_EVENTS = 64;
+
+Reactor::Reactor(std::size_t threadCount) : nextLoop(0), running(false) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    loops.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++) {
+        auto loop = std::make_unique<Loop>();
+
+        loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epoll < 0) {
+            throw std::logic_error("Reactor: Error to create epoll");
+        }
+
+        loop->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->wakeup < 0) {
+            ::close(loop->epoll);
+            throw std::logic_error("Reactor: Error to create eventfd");
+        }
+
+        epoll_event event{.events = EPOLLIN, .data = {.ptr = nullptr}};
+        epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->wakeup, &event);
+
+        loops.push_back(std::move(loop));
+    }
+}
+
+Reactor::~Reactor() {
+    stop();
+
+    for (auto& loop : loops) {
+        ::close(loop->wakeup);
+        ::close(loop->epoll);
+    }
+}
+
+void Reactor::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+
+    for (auto& loop : loops) {
+        Loop& ref = *loop;
+        loop->thread = std::thread([this, &ref]() { this->run(ref); });
+    }
+}
+
+void Reactor::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    for (auto& loop : loops) {
+        std::uint64_t one = 1;
+        ::write(loop->wakeup, &one, sizeof(one));
+    }
+    for (auto& loop : loops) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+
+        std::lock_guard<std::mutex> lock{loop->mutex};
+        loop->connections.clear();
+    }
+}
+
+void Reactor::add(std::shared_ptr<utils::Socket> socket, FrameHandler onFrame, CloseHandler onClose) {
+    socket->setBlocking(false);
+
+    Loop& loop = *loops[nextLoop++ % loops.size()];
+    int descriptor = socket->getDescriptor();
+
+    auto connection = std::make_unique<Connection>();
+    connection->descriptor = descriptor;
+    connection->socket  = std::move(socket);
+    connection->onFrame = std::move(onFrame);
+    connection->onClose = std::move(onClose);
+
+    epoll_event event{.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data = {.ptr = connection.get()}};
+
+    std::lock_guard<std::mutex> lock{loop.mutex};
+    if (epoll_ctl(loop.epoll, EPOLL_CTL_ADD, descriptor, &event) < 0) {
+        throw std::logic_error("Reactor: Error to register socket");
+    }
+    loop.connections[descriptor] = std::move(connection);
+}
+
+std::size_t Reactor::getThreadCount() const {
+    return loops.size();
+}
+
+std::size_t Reactor::getConnectionCount() const {
+    std::size_t count = 0;
+    for (const auto& loop : loops) {
+        std::lock_guard<std::mutex> lock{loop->mutex};
+        count += loop->connections.size();
+    }
+    return count;
+}
+
+void Reactor::flush() {
+    for (auto& loop : loops) {
+        std::lock_guard<std::mutex> lock{loop->mutex};
+        for (auto& [descriptor, connection] : loop->connections) {
+            try {
+                connection->socket->flush();
+            } catch (const std::logic_error& exception) {
+                // the I/O thread notices the hang up and drops it
+                connection->socket->close();
+            }
+        }
+    }
+}
+
+void Reactor::run(Loop& loop) {
+    std::array<epoll_event, MAX_EVENTS> events{};
+
+    while (running) {
+        int ready = epoll_wait(loop.epoll, events.data(), MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Reactor: epoll_wait failed" << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            auto* connection = static_cast<Connection*>(events[i].data.ptr);
+            if (connection == nullptr) {
+                std::uint64_t value;
+                ::read(loop.wakeup, &value, sizeof(value));
+                continue;
+            }
+
+            if (events[i].events & EPOLLIN) {
+                onReadable(*connection);
+            }
+            if (events[i].events & EPOLLOUT) {
+                onWritable(*connection);
+            }
+            // the connection may have been dropped while reading
+            if (!connection->socket->isConnected() || (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))) {
+                drop(loop, *connection);
+            }
+        }
+    }
+}
+
+void Reactor::onReadable(Connection& connection) {
+    auto& socket = *connection.socket;
+    auto& reader = connection.reader;
+
+    auto& metrics = PacketMetrics::global();
+
+    RawPacket rawPacket{};
+    try {
+        // edge-triggered, so we must drain the socket until it would block
+        while (reader.fill(socket) > 0) {
+            auto start = PacketMetrics::Clock::now();
+            while (reader.next(rawPacket)) {
+                metrics.received(rawPacket.id, rawPacket.data.size() + 2, PacketMetrics::nanosSince(start));
+                connection.onFrame(rawPacket);
+                if (rawPacket.data.capacity() <= std::string{}.capacity()) {
+                    rawPacket.data = utils::BufferPool::global().acquire();
+                }
+                start = PacketMetrics::Clock::now();
+            }
+        }
+    } catch (const std::length_error& exception) {
+        metrics.badFrame();
+        socket.close();
+        return;
+    } catch (const std::exception& exception) {
+        // either the peer is gone or it sent garbage, the connection is dropped after this
+        socket.close();
+        return;
+    }
+
+    // answers to this batch leave together
+    onWritable(connection);
+}
+
+void Reactor::onWritable(Connection& connection) {
+    auto& socket = *connection.socket;
+
+    try {
+        // whatever doesn't fit stays queued until the next EPOLLOUT
+        socket.flush();
+    } catch (const std::logic_error& exception) {
+        socket.close();
+    }
+}
+
+void Reactor::drop(Loop& loop, Connection& connection) {
+    int descriptor = connection.descriptor;
+    epoll_ctl(loop.epoll, EPOLL_CTL_DEL, descriptor, nullptr);
+
+    connection.socket->close();
+    if (connection.onClose) {
+        connection.onClose();
+    }
+
+    std::lock_guard<std::mutex> lock{loop.mutex};
+    loop.connections.erase(descriptor);
+}
@@ -0,0 +1,84 @@
+#ifndef MINICRAFTSERVER_REACTOR_H
+#define MINICRAFTSERVER_REACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Socket.h"
+#include "Protocol.h"
+#include "FrameReader.h"
+
+namespace mcplus {
+
+    /**
+     * Edge-triggered epoll event loop that owns every client socket.
+     *
+     * Connections are spread round-robin over a fixed set of I/O threads,
+     * each one waiting on its own epoll instance, so the thread count does
+     * not depend on how many players are connected. Complete frames are
+     * handed to the connection's FrameHandler on its I/O thread.
+     */
+    class Reactor {
+    public:
+        // may keep the frame's data, the next frame gets another buffer then
+        using FrameHandler = std::function<void(RawPacket&)>;
+        using CloseHandler = std::function<void()>;
+    private:
+        struct Connection {
+            int descriptor;
+            std::shared_ptr<utils::Socket> socket;
+            FrameReader reader;
+
+            FrameHandler onFrame;
+            CloseHandler onClose;
+        };
+
+        struct Loop {
+            int epoll;
+            int wakeup;
+            std::thread thread;
+
+            std::mutex mutex;
+            std::unordered_map<int, std::unique_ptr<Connection>> connections;
+        };
+
+        std::vector<std::unique_ptr<Loop>> loops;
+        std::atomic<std::size_t> nextLoop;
+        std::atomic<bool> running;
+
+        void run(Loop& loop);
+        void onReadable(Connection& connection);
+        void onWritable(Connection& connection);
+        void drop(Loop& loop, Connection& connection);
+    public:
+        explicit Reactor(std::size_t threadCount);
+        ~Reactor();
+
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        void start();
+        void stop();
+
+        void add(std::shared_ptr<utils::Socket> socket, FrameHandler onFrame, CloseHandler onClose);
+
+        /**
+         * Flushes every connection's send queue, it's meant to run once per tick
+         * so whatever a tick produced leaves in one writev per connection.
+         */
+        void flush();
+
+        [[nodiscard]] std::size_t getThreadCount() const;
+        [[nodiscard]] std::size_t getConnectionCount() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_REACTOR_H
@@ -0,0 +1,338 @@
+#include "RegionFile.h"
+#include "Utils.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace mcplus;
+
+static std::uint32_t readUint32(const char* bytes) {
+    return static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[0]))
+           | static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[1])) << 8
+           | static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[2])) << 16
+           | static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[3])) << 24;
+}
+
+static void writeUint32(char* bytes, std::uint32_t value) {
+    bytes[0] = static_cast<char>(value & 0xFF);
+    bytes[1] = static_cast<char>((value >> 8) & 0xFF);
+    bytes[2] = static_cast<char>((value >> 16) & 0xFF);
+    bytes[3] = static_cast<char>((value >> 24) & 0xFF);
+}
+
+RegionFile::RegionFile(const std::string& path) {
+    this->path    = path;
+    this->mapping = nullptr;
+    this->size    = 0;
+
+    int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        throw std::runtime_error("RegionFile: can't open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat status{};
+    if (fstat(descriptor, &status) < 0 || static_cast<std::size_t>(status.st_size) < HEADER_SIZE) {
+        ::close(descriptor);
+        throw std::runtime_error("RegionFile: " + path + " is too short");
+    }
+    this->size = static_cast<std::size_t>(status.st_size);
+
+    // the mapping keeps the file, a descriptor per region would run out of them
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    int error = errno;
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("RegionFile: can't map " + path + ": " + std::strerror(error));
+    }
+    this->mapping = static_cast<const char*>(mapped);
+
+    if (readUint32(mapping) != MAGIC || readUint32(mapping + 4) != VERSION) {
+        munmap(const_cast<char*>(mapping), size);
+        throw std::runtime_error("RegionFile: " + path + " isn't a region file");
+    }
+}
+
+RegionFile::~RegionFile() {
+    munmap(const_cast<char*>(mapping), size);
+}
+
+std::string RegionFile::pathOf(const std::string& directory, const Vector2i& regionPos) {
+    utils::TextEncoder encoder{};
+    encoder << directory << "/r." << regionPos.x << '.' << regionPos.y << ".mcr";
+    return encoder.take();
+}
+
+RegionFile::Slot RegionFile::slotAt(int index) const {
+    const char* slot = mapping + TABLE_START + static_cast<std::size_t>(index) * SLOT_SIZE;
+    return {readUint32(slot), readUint32(slot + 4), readUint32(slot + 8)};
+}
+
+const std::string& RegionFile::getPath() const {
+    return path;
+}
+
+bool RegionFile::contains(int index) const {
+    return slotAt(index).sector != 0;
+}
+
+std::string_view RegionFile::find(int index) const {
+    Slot slot = slotAt(index);
+    if (slot.sector == 0) {
+        return {};
+    }
+
+    std::size_t start = static_cast<std::size_t>(slot.sector) * SECTOR_SIZE;
+    if (slot.sector < FIRST_SECTOR || start > size || slot.length > size - start) {
+        throw std::runtime_error("RegionFile: chunk " + std::to_string(index) + " of " + path + " is out of the file");
+    }
+
+    std::string_view data{mapping + start, slot.length};
+    if (utils::crc32(data) != slot.checksum) {
+        throw std::runtime_error("RegionFile: chunk " + std::to_string(index) + " of " + path + " fails its checksum");
+    }
+
+    return data;
+}
+
+bool RegionFile::read(int index, Chunk& chunk) const {
+    std::string_view data = find(index);
+    if (data.empty()) {
+        return false;
+    }
+
+    if (!chunk.decode(data)) {
+        throw std::runtime_error("RegionFile: chunk " + std::to_string(index) + " of " + path + " can't be decoded");
+    }
+
+    return true;
+}
+
+std::size_t RegionFile::getSize() const {
+    return size;
+}
+
+// written next to path first and renamed over it, so path is never left half written
+static void replaceFile(const std::string& path, std::string_view contents) {
+    std::string temporary = path + ".tmp";
+    int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        throw std::runtime_error("RegionFile: can't create " + temporary + ": " + std::strerror(errno));
+    }
+
+    std::size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t result = ::write(descriptor, contents.data() + written, contents.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            int error = errno;
+            ::close(descriptor);
+            ::unlink(temporary.c_str());
+            throw std::runtime_error("RegionFile: can't write " + temporary + ": " + std::strerror(error));
+        }
+        written += static_cast<std::size_t>(result);
+    }
+
+    // on disk before the rename, or a crash could leave an empty file under the real name
+    bool synced = fsync(descriptor) == 0;
+    int error = errno;
+    if (::close(descriptor) < 0 && synced) {
+        synced = false;
+        error  = errno;
+    }
+
+    if (!synced || rename(temporary.c_str(), path.c_str()) < 0) {
+        error = synced ? errno : error;
+        ::unlink(temporary.c_str());
+        throw std::runtime_error("RegionFile: can't replace " + path + ": " + std::strerror(error));
+    }
+}
+
+void RegionFile::write(const std::string& path, const std::vector<ChunkData>& chunks, const RegionFile* previous) {
+    std::string file(FIRST_SECTOR * SECTOR_SIZE, '\0');
+    writeUint32(file.data(), MAGIC);
+    writeUint32(file.data() + 4, VERSION);
+
+    auto next = chunks.begin();
+    for (int index = 0; index < Region::REGION_SIZE; index++) {
+        std::string_view data{};
+        if (next != chunks.end() && next->index == index) {
+            data = next->data;
+            ++next;
+        } else if (previous != nullptr) {
+            try {
+                data = previous->find(index);
+            } catch (const std::runtime_error& exception) {
+                // a damaged chunk can't be carried over, it gets generated again
+                data = {};
+            }
+        }
+
+        if (data.empty()) {
+            continue;
+        }
+
+        auto sector = static_cast<std::uint32_t>(file.size() / SECTOR_SIZE);
+        char* slot = file.data() + TABLE_START + static_cast<std::size_t>(index) * SLOT_SIZE;
+        writeUint32(slot, sector);
+        writeUint32(slot + 4, static_cast<std::uint32_t>(data.size()));
+        writeUint32(slot + 8, utils::crc32(data));
+
+        file.append(data);
+        file.resize((file.size() + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE, '\0');
+    }
+
+    replaceFile(path, file);
+}
+
+static uint64_t regionKey(const Vector2i& regionPos) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(regionPos.x)) << 32 | static_cast<uint32_t>(regionPos.y);
+}
+
+RegionStorage::RegionStorage(const std::string& directory) {
+    std::filesystem::create_directories(directory);
+
+    this->directory     = directory;
+    this->files         = {};
+    this->pendingWrites = {};
+    this->unwritten     = {};
+}
+
+const std::string& RegionStorage::getDirectory() const {
+    return directory;
+}
+
+std::shared_ptr<RegionFile> RegionStorage::findFile(const Vector2i& regionPos) {
+    uint64_t key = regionKey(regionPos);
+    auto it = files.find(key);
+    if (it != files.end()) {
+        return it->second;
+    }
+
+    // only cached once opened, a file that failed isn't taken for a missing one
+    std::shared_ptr<RegionFile> file;
+    std::string path = RegionFile::pathOf(directory, regionPos);
+    if (std::filesystem::exists(path)) {
+        file = std::make_shared<RegionFile>(path);
+    }
+    files.emplace(key, file);
+    return file;
+}
+
+bool RegionStorage::read(const Vector2i& chunkPos, Chunk& chunk) {
+    Vector2i regionPos = ChunkStore::regionOf(chunkPos);
+    uint64_t key = regionKey(regionPos);
+    int index = Region::indexOf(chunkPos);
+
+    std::shared_ptr<RegionFile> file;
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        written.wait(lock, [this, key]() { return pendingWrites.find(key) == pendingWrites.end(); });
+
+        auto failed = unwritten.find(key);
+        if (failed != unwritten.end()) {
+            for (const auto& data : failed->second) {
+                if (data.index == index) {
+                    return chunk.decode(data.data);
+                }
+            }
+        }
+
+        file = findFile(regionPos);
+    }
+
+    // the file stays mapped while read, even if a write replaces it meanwhile
+    return file != nullptr && file->read(index, chunk);
+}
+
+void RegionStorage::beginWrite(const Vector2i& regionPos) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pendingWrites[regionKey(regionPos)]++;
+}
+
+void RegionStorage::endWrite(uint64_t key) {
+    auto it = pendingWrites.find(key);
+    if (--it->second == 0) {
+        pendingWrites.erase(it);
+    }
+    written.notify_all();
+}
+
+void RegionStorage::write(const Vector2i& regionPos, std::vector<RegionFile::ChunkData> chunks) {
+    uint64_t key = regionKey(regionPos);
+    std::string path = RegionFile::pathOf(directory, regionPos);
+
+    auto byIndex = [](const RegionFile::ChunkData& a, const RegionFile::ChunkData& b) {
+        return a.index < b.index;
+    };
+
+    std::shared_ptr<RegionFile> previous;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto failed = unwritten.find(key);
+        if (failed != unwritten.end()) {
+            // older than the chunks written now, only the ones they don't replace are kept
+            std::sort(chunks.begin(), chunks.end(), byIndex);
+            std::size_t newer = chunks.size();
+            for (auto& data : failed->second) {
+                if (!std::binary_search(chunks.begin(), chunks.begin() + static_cast<std::ptrdiff_t>(newer), data, byIndex)) {
+                    chunks.push_back(std::move(data));
+                }
+            }
+            unwritten.erase(failed);
+        }
+
+        try {
+            previous = findFile(regionPos);
+        } catch (const std::runtime_error& exception) {
+            // replacing a file that can't be read would lose every chunk not in chunks
+            unwritten[key] = std::move(chunks);
+            endWrite(key);
+            throw;
+        }
+    }
+    std::sort(chunks.begin(), chunks.end(), byIndex);
+
+    std::shared_ptr<RegionFile> file;
+    try {
+        RegionFile::write(path, chunks, previous.get());
+        file = std::make_shared<RegionFile>(path);
+    } catch (const std::runtime_error& exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+        unwritten[key] = std::move(chunks);
+        endWrite(key);
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    files[key] = std::move(file);
+    endWrite(key);
+}
+
+bool RegionStorage::readEntities(std::string& data) {
+    std::ifstream file{directory + "/" + ENTITY_FILE, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        throw std::runtime_error("RegionStorage: can't read " + directory + "/" + ENTITY_FILE);
+    }
+    return true;
+}
+
+void RegionStorage::writeEntities(std::string_view data) {
+    replaceFile(directory + "/" + ENTITY_FILE, data);
+}
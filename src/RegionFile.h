@@ -0,0 +1,166 @@
+#ifndef MINICRAFTSERVER_REGIONFILE_H
+#define MINICRAFTSERVER_REGIONFILE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Dimension.h"
+#include "World.h"
+
+namespace mcplus {
+
+    /**
+     * One Region on disk, read through a read-only memory mapping.
+     *
+     * The file starts with a header (magic, version) and a slot table of
+     * REGION_SIZE entries: first sector, length and CRC-32 of every chunk
+     * saved, sector 0 meaning the chunk isn't there. Chunks follow, each
+     * one padded to whole SECTOR_SIZE sectors. Opening a file only maps it,
+     * the kernel reads the pages of the table and of a chunk the first time
+     * they are touched.
+     *
+     * Files are never modified in place: write() builds the next version
+     * next to it and renames it over, so a crash leaves the old one intact
+     * and mappings of the old one stay valid.
+     */
+    class RegionFile {
+    public:
+        static constexpr std::uint32_t MAGIC   = 0x4752434D; // "MCRG" read little-endian
+        static constexpr std::uint32_t VERSION = 1;
+        static constexpr std::size_t SECTOR_SIZE = 256;
+        static constexpr std::size_t SLOT_SIZE   = 12;
+        static constexpr std::size_t TABLE_START = 8;
+        static constexpr std::size_t HEADER_SIZE = TABLE_START + Region::REGION_SIZE * SLOT_SIZE;
+        static constexpr std::size_t FIRST_SECTOR = (HEADER_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+        // a chunk as Chunk::encode() wrote it, at its index in the region
+        struct ChunkData {
+            int index;
+            std::string data;
+        };
+    private:
+        struct Slot {
+            std::uint32_t sector;
+            std::uint32_t length;
+            std::uint32_t checksum;
+        };
+
+        std::string path;
+        const char* mapping;
+        std::size_t size;
+
+        [[nodiscard]] Slot slotAt(int index) const;
+    public:
+        /**
+         * Maps an existing file, throws std::runtime_error if it can't or
+         * the file isn't a region file.
+         */
+        explicit RegionFile(const std::string& path);
+        ~RegionFile();
+
+        RegionFile(const RegionFile&) = delete;
+        RegionFile& operator=(const RegionFile&) = delete;
+
+        /**
+         * r.<x>.<y>.mcr in directory.
+         */
+        static std::string pathOf(const std::string& directory, const Vector2i& regionPos);
+
+        /**
+         * Writes chunks, sorted by index, to path. The chunks they don't
+         * cover but previous (the file being replaced) has are copied over
+         * as they are, so only what changed needs encoding.
+         */
+        static void write(const std::string& path, const std::vector<ChunkData>& chunks, const RegionFile* previous);
+
+        [[nodiscard]] const std::string& getPath() const;
+        [[nodiscard]] bool contains(int index) const;
+
+        /**
+         * The stored bytes of a chunk, checksum verified, empty when it isn't
+         * there. Throws std::runtime_error if it was damaged.
+         */
+        [[nodiscard]] std::string_view find(int index) const;
+
+        /**
+         * Decodes a chunk into chunk. False when the file doesn't have it,
+         * throws std::runtime_error if it was damaged.
+         */
+        bool read(int index, Chunk& chunk) const;
+
+        [[nodiscard]] std::size_t getSize() const;
+    };
+
+    /**
+     * The region files of one world directory, shared by the tick and the
+     * ChunkIO threads.
+     *
+     * A write is announced with beginWrite() when it gets queued: reads of
+     * that region wait until it is done, so a chunk read back right after
+     * being written is never the older copy.
+     */
+    class RegionStorage {
+    public:
+        // the entities of the world, next to its region files
+        static constexpr const char* ENTITY_FILE = "entities.dat";
+    private:
+        std::string directory;
+
+        std::mutex mutex;
+        std::condition_variable written;
+        // mapped on first use, null for a region without a file yet; a file
+        // that fails to open isn't cached, the next use tries it again
+        std::unordered_map<uint64_t, std::shared_ptr<RegionFile>> files;
+        std::unordered_map<uint64_t, std::size_t> pendingWrites;
+        // chunks of failed writes, put under the next write of their region
+        std::unordered_map<uint64_t, std::vector<RegionFile::ChunkData>> unwritten;
+
+        std::shared_ptr<RegionFile> findFile(const Vector2i& regionPos);
+        void endWrite(uint64_t key);
+    public:
+        /**
+         * Creates directory if missing. Nothing is read yet.
+         */
+        explicit RegionStorage(const std::string& directory);
+
+        RegionStorage(const RegionStorage&) = delete;
+        RegionStorage& operator=(const RegionStorage&) = delete;
+
+        [[nodiscard]] const std::string& getDirectory() const;
+
+        /**
+         * Reads the saved chunk at chunkPos into chunk, false when there is
+         * none. Throws std::runtime_error if it was damaged.
+         */
+        bool read(const Vector2i& chunkPos, Chunk& chunk);
+
+        void beginWrite(const Vector2i& regionPos);
+        /**
+         * Replaces the region file with one holding chunks, ending the write
+         * begun by beginWrite(). If that fails, or the file being replaced
+         * can't be opened to carry its other chunks over, the chunks are
+         * kept for the next write of the region and std::runtime_error is
+         * thrown.
+         */
+        void write(const Vector2i& regionPos, std::vector<RegionFile::ChunkData> chunks);
+
+        /**
+         * The entity file as last written, false when there is none yet.
+         */
+        bool readEntities(std::string& data);
+        /**
+         * Replaces the entity file. Throws std::runtime_error if that fails,
+         * the old one is left as it was.
+         */
+        void writeEntities(std::string_view data);
+    };
+
+}
+
+#endif // MINICRAFTSERVER_REGIONFILE_H
@@ -1,17 +1,38 @@
 #include "Server.h"
 #include "Packet.h"
 #include "Utils.h"
+#include "Metrics.h"
 
+#include <poll.h>
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <thread>
 #include <utility>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
 
 using namespace mcplus;
 
-static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPacket);
+static bool defaultPacketHandler(PlayerSocket& player, const RawPacket& rawPacket);
+static void serveMetrics(utils::Socket& client);
+
+// the Minicraft+ levels by depth: the sky, the surface and four below it
+static const std::pair<WorldId, const char*> LEVELS[] = {
+        {1, "sky"}, {0, "surface"}, {-1, "iron"}, {-2, "gold"}, {-3, "lava"}, {-4, "dungeon"}
+};
 static std::unordered_map<std::string, std::shared_ptr<CommandExecutor>> defaultCommandMap();
 
+// whether the server has a level, its worldMap holds exactly LEVELS
+static bool isLevel(int32_t level) {
+    return std::any_of(std::begin(LEVELS), std::end(LEVELS), [level](const auto& entry) {
+        return entry.first == level;
+    });
+}
+
 class CommandSender : public Sender {
 public:
     CommandSender() = default;
@@ -25,59 +46,232 @@ void CommandSender::sendMessage(const std::string& message) const {
 
 PlayerSocket::PlayerSocket(std::shared_ptr<utils::Socket> socket) {
     this->socket = std::move(socket);
-    this->thread = nullptr;
+    this->badPackets = 0;
+    this->extensions = 0;
+    this->location = {};
+    this->viewWorld = {};
+    this->previousLocation = {};
+    this->previousMoveTick = 0;
+    this->prefetchedChunk = {};
+    this->predictedChunk = {};
+    this->heldWorld = {};
+    this->heldChunk = {};
+    this->pendingLoad = {};
+    // the surface until a LOAD says otherwise
+    this->inboundWorld = 0;
+    this->receivedPackets = 0;
+    this->droppedPackets = 0;
     this->packetHandler = defaultPacketHandler;
 }
 
-PlayerSocket::~PlayerSocket() {
-    if (thread == nullptr) {
+void PlayerSocket::handle(const RawPacket& rawPacket) {
+    if (!isConnected()) {
         return;
     }
 
-    thread->detach();
-    delete thread;
-}
+    auto start = PacketMetrics::Clock::now();
+    bool accepted = false;
+    try {
+        accepted = packetHandler(*this, rawPacket);
+    } catch (const std::exception& exception) {
+        std::cerr << socket->getIP() << ':' << socket->getPort() << " sent a bad packet " << exception.what() << std::endl;
+    }
+    PacketMetrics::global().handled(rawPacket.id, PacketMetrics::nanosSince(start), accepted);
 
-void PlayerSocket::run() {
-    int bad_packets = 0;
-    while (this->isConnected()) {
-        try {
-            if (packetHandler(*socket, readPacket(*socket))) {
-                bad_packets = 0;
-            } else {
-                bad_packets++;
-            }
-        } catch (const std::logic_error& exception) {
-            std::cerr << socket->getIP() << ':' << socket->getPort() << " got disconnected " << exception.what() << std::endl;
-        }
+    badPackets = accepted ? 0 : badPackets + 1;
 
-        if (bad_packets > 15) {
+    if (badPackets > 15) {
+        try {
             writePacket(*socket, InvalidPacket("Many bad packets"));
-            socket->close();
+        } catch (const std::logic_error& exception) {
+            // it is being kicked anyway
         }
+        socket->close();
     }
 }
 
-void PlayerSocket::start() {
-    if (thread != nullptr) {
-        return;
-    }
+bool PlayerSocket::isConnected() const {
+    return socket->isConnected();
+}
 
-    thread = new std::thread([this](){this->run();});
+bool PlayerSocket::hasExtension(Extension extension) const {
+    return (extensions & static_cast<uint32_t>(extension)) != 0;
 }
 
-bool PlayerSocket::isConnected() const {
-    return socket->isConnected();
+void PlayerSocket::enableExtension(Extension extension) {
+    extensions |= static_cast<uint32_t>(extension);
+}
+
+std::optional<Location2f> PlayerSocket::getLocation() const {
+    std::lock_guard<std::mutex> lock{locationMutex};
+    return location;
 }
 
-Server::Server(const std::string &ip, short port) {
+void PlayerSocket::setLocation(const Location2f& location) {
+    std::lock_guard<std::mutex> lock{locationMutex};
+    this->location = location;
+}
+
+InboundQueue::InboundQueue() : queue(CAPACITY) {
+    this->dropped = 0;
+}
+
+Server::Server(const std::string &ip, short port) : generator(std::random_device{}() | static_cast<WorldSeed>(std::random_device{}()) << 32) {
     this->socketServer = std::make_unique<utils::SocketServer>(port, 100);
+    try {
+        this->metricsServer = std::make_unique<utils::SocketServer>("127.0.0.1", METRICS_PORT, 8);
+    } catch (const std::logic_error& exception) {
+        // the game runs fine without it
+        std::cerr << "Metrics endpoint disabled: " << exception.what() << std::endl;
+    }
+    // a small fixed pool, I/O threads mostly wait on epoll
+    this->reactor = std::make_unique<Reactor>(std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u));
+    this->scheduler = std::make_unique<TickScheduler>(60);
     this->running = false;
-
-    this->worldMap  = {};
+    this->saveRequested = false;
+
+    this->jobs = std::make_unique<JobSystem>();
+    this->chunkIO = std::make_unique<ChunkIO>();
+    this->tickCount = 0;
+    this->loadingChunks = 0;
+    this->chunkMemory = 0;
+    this->chunkBudget = DEFAULT_CHUNK_BUDGET;
+
+    this->worldMap.clear();
+    this->interestMap = {};
+    for (const auto& [id, name] : LEVELS) {
+        this->worldMap.emplace(std::piecewise_construct, std::forward_as_tuple(id), std::forward_as_tuple(id, name));
+        this->worldMap.at(id).setGenerator(&generator);
+        this->interestMap.emplace(id, InterestManager{});
+        this->inboundMap.emplace(id, std::make_unique<InboundQueue>());
+    }
     this->socketList = {};
+    this->leftPlayers = {};
     this->listenerList = {};
     this->commandMap = std::move(defaultCommandMap());
+    this->worldJobs = {};
+    this->departures = {};
+
+    // worlds don't share state, so each level is a job, and splits its own ticking into more
+    scheduler->addSystem("world", [this]() {
+        worldJobs.clear();
+        for (auto& [id, world] : worldMap) {
+            worldJobs.emplace_back([this, id = id, &world]() {
+                drainInbound(id);
+                world.tick(jobs.get());
+            });
+        }
+        jobs->run(worldJobs);
+    });
+    scheduler->addSystem("transfer", [this]() {
+        transferEntities();
+    });
+    scheduler->addSystem("interest", [this]() {
+        updateViews();
+
+        // a player is subscribed to one world only, and sockets lock their own send queue
+        worldJobs.clear();
+        for (auto& [id, interest] : interestMap) {
+            worldJobs.emplace_back([&interest, &world = worldMap.at(id)]() {
+                interest.update(world);
+            });
+        }
+        jobs->run(worldJobs);
+    });
+    scheduler->addSystem("network", [this]() {
+        reactor->flush();
+    });
+    // a snapshot costs a pointer per dirty chunk, encoding and the disk are left to the ChunkIO writer
+    scheduler->addSystem("storage", [this]() {
+        tickCount++;
+
+        std::size_t loading = 0;
+        std::size_t memory = 0;
+        for (auto& [id, world] : worldMap) {
+            world.setMemoryBudget(chunkBudget.load(std::memory_order_relaxed));
+            loading += world.getLoadingCount();
+            memory += world.getLastMemoryUsage();
+        }
+        loadingChunks.store(loading, std::memory_order_relaxed);
+        chunkMemory.store(memory, std::memory_order_relaxed);
+
+        bool requested = saveRequested.exchange(false);
+        if (requested || tickCount % WRITE_BACK_TICKS == 0) {
+            std::size_t written = writeBackWorlds();
+            if (requested) {
+                std::cout << "Writing " << written << " chunks\n";
+            }
+        }
+    });
+}
+
+void Server::loadWorld(const std::string& worldName) {
+    std::string directory = "worlds/" + worldName;
+    std::filesystem::create_directories(directory);
+
+    // chunks nobody changed aren't saved, they only come back the same with the same seed
+    std::ifstream seedIn{directory + "/seed"};
+    WorldSeed seed;
+    if (seedIn >> seed) {
+        generator = WorldGenerator{seed};
+    } else {
+        std::ofstream seedOut{directory + "/seed"};
+        if (!(seedOut << generator.getSeed() << '\n')) {
+            throw std::runtime_error("Couldn't write the seed of " + directory);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t loaded = 0;
+    std::size_t entities = 0;
+    for (auto& [id, world] : worldMap) {
+        world.open(directory + "/" + world.getName(), chunkIO.get());
+        try {
+            entities += world.loadEntities();
+        } catch (const std::runtime_error& exception) {
+            std::cerr << exception.what() << std::endl;
+        }
+        try {
+            loaded += world.pregenerate({0, 0}, {PREGENERATE_SIZE / static_cast<int>(Chunk::CHUNK_WIDTH),
+                                                 PREGENERATE_SIZE / static_cast<int>(Chunk::CHUNK_HEIGHT)}, jobs.get());
+        } catch (const std::runtime_error& exception) {
+            std::cerr << exception.what() << std::endl;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Loaded " << loaded << " chunks of seed " << generator.getSeed() << " and " << entities << " entities in "
+              << elapsed.count() << "ms\n";
+}
+
+void Server::unloadWorld(WorldId id) {
+    World& world = worldMap.at(id);
+    if (!world.isOpen()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t saved = world.save();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    if (saved > 0) {
+        std::cout << "Saved " << saved << " chunks of " << world.getName() << " in " << elapsed.count() << "ms\n";
+    }
+}
+
+void Server::requestSave() {
+    saveRequested = true;
+}
+
+std::size_t Server::writeBackWorlds() {
+    std::size_t written = 0;
+    for (auto& [id, world] : worldMap) {
+        if (world.isOpen()) {
+            written += world.writeBack();
+        }
+    }
+
+    return written;
 }
 
 bool Server::dispatchCommand(const std::string& command) {
@@ -98,6 +292,7 @@ bool Server::dispatchCommand(const std::string& command) {
 
 void Server::run() {
     running = true;
+    reactor->start();
 
     std::thread joinerThread([&]() {
         std::cout << "Connection thread started\n";
@@ -106,8 +301,21 @@ void Server::run() {
                 std::shared_ptr<utils::Socket> socket = socketServer->acceptSock();
                 std::cout << "Connected socket! " << socket->getIP() << ":" << socket->getPort() << "\n";
 
-                socketList.emplace_back(socket);
-                socketList[socketList.size() - 1].start();
+                auto player = std::make_shared<PlayerSocket>(socket);
+                {
+                    std::lock_guard<std::mutex> lock{socketMutex};
+                    socketList.push_back(player);
+                }
+
+                reactor->add(socket, [this, player](RawPacket& rawPacket) {
+                    receive(player, rawPacket);
+                }, [this, player]() {
+                    std::cout << "Disconnected socket! " << player->socket->getIP() << ":" << player->socket->getPort() << "\n";
+
+                    std::lock_guard<std::mutex> lock{socketMutex};
+                    socketList.erase(std::remove(socketList.begin(), socketList.end(), player), socketList.end());
+                    leftPlayers.push_back(player);
+                });
             } catch (const std::logic_error& exception) {
                 if (running) {
                     throw exception;
@@ -116,36 +324,309 @@ void Server::run() {
         }
     });
 
+    std::thread metricsThread([&]() {
+        while (running && metricsServer) {
+            std::shared_ptr<utils::Socket> client;
+            try {
+                client = metricsServer->acceptSock();
+            } catch (const std::logic_error& exception) {
+                break;
+            }
+
+            try {
+                serveMetrics(*client);
+            } catch (const std::logic_error& exception) {
+                // the scraper went away, the next one gets its answer
+            }
+        }
+    });
+
     std::cout << "Main thread started\n";
 
-    auto oldClock = std::chrono::high_resolution_clock::now();
-    auto tps = 1000000000.0f / 60.0f;
-    double delta = 0;
+    scheduler->run(running);
 
-    int ticks = 0;
+    reactor->stop();
+    for (auto& [id, world] : worldMap) {
+        try {
+            unloadWorld(id);
+        } catch (const std::runtime_error& exception) {
+            // the previous files are untouched
+            std::cerr << "Couldn't save " << world.getName() << ": " << exception.what() << std::endl;
+        }
+    }
+    joinerThread.detach();
+    metricsThread.detach();
+}
 
-    auto timer = std::chrono::high_resolution_clock::now();
+void Server::updateViews() {
+    std::lock_guard<std::mutex> lock{socketMutex};
 
-    while (running) {
-        auto nowClock = std::chrono::high_resolution_clock::now();
-        delta += (nowClock - oldClock).count() / tps;
-        oldClock = nowClock;
+    for (auto& player : leftPlayers) {
+        holdChunks(*player, std::nullopt);
+    }
+    leftPlayers.clear();
 
-        while (delta > 0) {
-            ticks++;
+    for (auto& player : socketList) {
+        auto location = player->getLocation();
+        if (!location.has_value() || interestMap.find(location->world) == interestMap.end()) {
+            continue;
+        }
 
-            delta--;
+        if (player->pendingLoad.has_value()) {
+            // reset first, so a level that fails to send isn't tried on every tick
+            WorldId level = player->pendingLoad.value();
+            player->pendingLoad.reset();
+            if (!sendLevel(*player, level)) {
+                // still loading, it goes out on a later tick
+                player->pendingLoad = level;
+            }
         }
 
-        // take a mini break :]
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
-        if ((std::chrono::high_resolution_clock::now() - timer).count() >= 1000000000) {
-            ticks = 0;
-            timer = std::chrono::high_resolution_clock::now();
+        prefetchChunks(*player, location.value());
+        holdChunks(*player, location);
+
+        auto position = static_cast<Vector2f>(location.value());
+        if (player->viewWorld == location->world) {
+            interestMap.at(location->world).moveView(*player->socket, position);
+            continue;
+        }
+
+        if (player->viewWorld.has_value()) {
+            interestMap.at(player->viewWorld.value()).unsubscribe(*player->socket);
+        }
+        interestMap.at(location->world).subscribe(player->socket, position);
+        player->viewWorld = location->world;
+
+        WorldId previous;
+        {
+            std::lock_guard<std::mutex> routeLock{player->routeMutex};
+            previous = player->inboundWorld;
+            player->inboundWorld = location->world;
+        }
+        // what the player sent before the switch is still over there, handle it
+        // now so the new world never runs ahead of it
+        if (previous != location->world) {
+            drainInbound(previous);
         }
     }
+}
 
-    joinerThread.detach();
+static Vector2i chunkOf(float x, float y) {
+    return {static_cast<int>(std::floor(x / static_cast<float>(Chunk::CHUNK_WIDTH))),
+            static_cast<int>(std::floor(y / static_cast<float>(Chunk::CHUNK_HEIGHT)))};
+}
+
+void Server::prefetchChunks(PlayerSocket& player, const Location2f& location) {
+    auto position = static_cast<Vector2f>(location);
+    bool sameWorld = player.previousLocation.has_value() && player.previousLocation->world == location.world;
+    if (sameWorld && static_cast<Vector2f>(player.previousLocation.value()) == position) {
+        return;
+    }
+
+    // tiles per tick since the last move, MOVE packets don't come every tick
+    Vector2f velocity{0, 0};
+    if (sameWorld) {
+        auto elapsed = static_cast<float>(std::max<std::uint64_t>(tickCount - player.previousMoveTick, 1));
+        Vector2f moved = position - static_cast<Vector2f>(player.previousLocation.value());
+        velocity = {moved.x / elapsed, moved.y / elapsed};
+    }
+    player.previousLocation = location;
+    player.previousMoveTick = tickCount;
+
+    Vector2i current   = chunkOf(position.x, position.y);
+    Vector2i predicted = chunkOf(position.x + velocity.x * PREFETCH_TICKS, position.y + velocity.y * PREFETCH_TICKS);
+    int steps = std::max(std::abs(predicted.x - current.x), std::abs(predicted.y - current.y));
+    if (steps > PREFETCH_STEPS) {
+        // a teleport more than a walk, there is no telling where it goes next
+        predicted = current;
+        steps     = 0;
+    }
+    if (sameWorld && current == player.prefetchedChunk && predicted == player.predictedChunk) {
+        return;
+    }
+    player.prefetchedChunk = current;
+    player.predictedChunk  = predicted;
+
+    // the view around every chunk on the way, the nearest first so they are read first
+    World& world = worldMap.at(location.world);
+    constexpr int radius = InterestManager::DEFAULT_VIEW_RADIUS;
+    for (int step = 0; step <= steps; step++) {
+        int centerX = current.x + (steps == 0 ? 0 : (predicted.x - current.x) * step / steps);
+        int centerY = current.y + (steps == 0 ? 0 : (predicted.y - current.y) * step / steps);
+        for (int x = centerX - radius; x <= centerX + radius; x++) {
+            for (int y = centerY - radius; y <= centerY + radius; y++) {
+                world.requestChunk({x, y});
+            }
+        }
+    }
+}
+
+bool Server::sendLevel(PlayerSocket& player, WorldId level) {
+    World& world = worldMap.at(level);
+    constexpr int chunksX = LEVEL_SIZE / static_cast<int>(Chunk::CHUNK_WIDTH);
+    constexpr int chunksY = LEVEL_SIZE / static_cast<int>(Chunk::CHUNK_HEIGHT);
+
+    // the tick never waits for chunk I/O, evicted chunks are read back on ChunkIO first
+    bool loaded = true;
+    for (int chunkY = 0; chunkY < chunksY; chunkY++) {
+        for (int chunkX = 0; chunkX < chunksX; chunkX++) {
+            loaded &= world.requestChunk({chunkX, chunkY});
+        }
+    }
+    if (!loaded) {
+        return false;
+    }
+
+    std::vector<Tile> tiles(LEVEL_SIZE * LEVEL_SIZE);
+    for (int chunkY = 0; chunkY < chunksY; chunkY++) {
+        for (int chunkX = 0; chunkX < chunksX; chunkX++) {
+            const Chunk& chunk = std::as_const(world).getChunkAt({chunkX, chunkY});
+            for (int y = 0; y < static_cast<int>(Chunk::CHUNK_HEIGHT); y++) {
+                for (int x = 0; x < static_cast<int>(Chunk::CHUNK_WIDTH); x++) {
+                    int tileX = chunkX * static_cast<int>(Chunk::CHUNK_WIDTH) + x;
+                    int tileY = chunkY * static_cast<int>(Chunk::CHUNK_HEIGHT) + y;
+                    tiles[tileX + tileY * LEVEL_SIZE] = chunk.getTileAt({x, y});
+                }
+            }
+        }
+    }
+
+    utils::Socket& client = *player.socket;
+    if (player.hasExtension(Extension::BINARY_TILES)) {
+        queuePacket(client, BinaryTilesPacket{tiles});
+    } else {
+        queuePacket(client, TilesPacket{tiles});
+    }
+    queuePacket(client, EntitiesPacket{std::vector<std::shared_ptr<Entity>>{}});
+    queuePacket(client, GamePacket("survival", 6000, 1, true, 10, 1, 1));
+    return true;
+}
+
+void Server::holdChunks(PlayerSocket& player, const std::optional<Location2f>& location) {
+    constexpr int radius = InterestManager::DEFAULT_VIEW_RADIUS;
+
+    std::optional<WorldId> world{};
+    Vector2i chunk{};
+    if (location.has_value()) {
+        world = location->world;
+        chunk = chunkOf(location->x, location->y);
+    }
+    if (player.heldWorld == world && (!world.has_value() || player.heldChunk == chunk)) {
+        return;
+    }
+
+    // the new window first, so the chunks both hold never look unused
+    if (world.has_value()) {
+        worldMap.at(world.value()).retainChunks(chunk, radius);
+    }
+    if (player.heldWorld.has_value()) {
+        worldMap.at(player.heldWorld.value()).releaseChunks(player.heldChunk, radius);
+    }
+    player.heldWorld = world;
+    player.heldChunk = chunk;
+}
+
+void Server::receive(const std::shared_ptr<PlayerSocket>& player, RawPacket& rawPacket) {
+    player->receivedPackets.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock{player->routeMutex};
+    InboundQueue& inbound = *inboundMap.at(player->inboundWorld);
+    if (inbound.queue.push(InboundPacket{player, std::move(rawPacket)})) {
+        return;
+    }
+
+    inbound.dropped.fetch_add(1, std::memory_order_relaxed);
+    // once, the inbound command tells how bad it got
+    if (player->droppedPackets.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::cerr << player->socket->getIP() << ':' << player->socket->getPort()
+                  << " is flooding world " << player->inboundWorld << ", dropping its packets" << std::endl;
+    }
+}
+
+void Server::drainInbound(WorldId id) {
+    InboundQueue& inbound = *inboundMap.at(id);
+
+    InboundPacket inboundPacket{};
+    while (inbound.queue.pop(inboundPacket)) {
+        inboundPacket.player->handle(inboundPacket.packet);
+        utils::BufferPool::global().release(std::move(inboundPacket.packet.data));
+    }
+    inboundPacket = {};
+}
+
+void Server::transferEntities() {
+    for (auto& [id, world] : worldMap) {
+        departures.clear();
+        world.takeDepartures(departures);
+
+        for (EntityId departed : departures) {
+            std::shared_ptr<Entity> entity = world.getEntity(departed);
+            world.removeEntity(departed);
+
+            // without a world to go to, dropping the handle is the end of it
+            auto target = worldMap.find(entity->getLocation().world);
+            if (target != worldMap.end()) {
+                target->second.addEntity(entity);
+            }
+        }
+    }
+}
+
+TickScheduler::Statistics Server::getTickStatistics() const {
+    return scheduler->getStatistics();
+}
+
+ChunkIO::Statistics Server::getChunkIOStatistics() const {
+    return chunkIO->getStatistics();
+}
+
+std::size_t Server::getLoadingChunks() const {
+    return loadingChunks.load(std::memory_order_relaxed);
+}
+
+std::size_t Server::getChunkMemory() const {
+    return chunkMemory.load(std::memory_order_relaxed);
+}
+
+std::size_t Server::getChunkBudget() const {
+    return chunkBudget.load(std::memory_order_relaxed);
+}
+
+void Server::setChunkBudget(std::size_t bytes) {
+    chunkBudget.store(bytes, std::memory_order_relaxed);
+}
+
+std::vector<Server::InboundStatistics> Server::getInboundStatistics() const {
+    std::vector<InboundStatistics> statistics{};
+    for (const auto& [id, inbound] : inboundMap) {
+        statistics.push_back({id, inbound->queue.size(), inbound->queue.capacity(), inbound->dropped.load(std::memory_order_relaxed)});
+    }
+    std::sort(statistics.begin(), statistics.end(), [](const InboundStatistics& a, const InboundStatistics& b) {
+        return a.world > b.world;
+    });
+
+    return statistics;
+}
+
+std::vector<Server::ConnectionStatistics> Server::getBusiestConnections(std::size_t limit) {
+    std::vector<ConnectionStatistics> statistics{};
+    {
+        std::lock_guard<std::mutex> lock{socketMutex};
+        for (const auto& player : socketList) {
+            statistics.push_back({player->socket->getIP() + ':' + std::to_string(player->socket->getPort()),
+                                  player->receivedPackets.load(std::memory_order_relaxed),
+                                  player->droppedPackets.load(std::memory_order_relaxed)});
+        }
+    }
+
+    std::sort(statistics.begin(), statistics.end(), [](const ConnectionStatistics& a, const ConnectionStatistics& b) {
+        return a.dropped != b.dropped ? a.dropped > b.dropped : a.received > b.received;
+    });
+    if (statistics.size() > limit) {
+        statistics.resize(limit);
+    }
+
+    return statistics;
 }
 
 bool Server::isShutdown() const {
@@ -161,12 +642,58 @@ void Server::shutdown() {
     std::cout << "Shutdown!\n";
 }
 
-static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPacket) {
+// one HTTP/1.0 exchange: whatever the request, up to its blank line, then the metrics and close
+static void serveMetrics(utils::Socket& client) {
+    static constexpr std::size_t MAX_REQUEST = 8 * 1024;
+    static constexpr int READ_TIMEOUT_MILLIS = 1000;
+
+    client.setBlocking(false);
+
+    std::string request{};
+    char bytes[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST) {
+        std::size_t read = client.readSome(reinterpret_cast<std::uint8_t*>(bytes), sizeof(bytes));
+        if (read > 0) {
+            request.append(bytes, read);
+            continue;
+        }
+
+        pollfd descriptor{.fd = client.getDescriptor(), .events = POLLIN, .revents = 0};
+        if (poll(&descriptor, 1, READ_TIMEOUT_MILLIS) <= 0) {
+            return;
+        }
+    }
+
+    utils::TextEncoder body{};
+    std::string status = "200 OK";
+    if (request.rfind("GET /metrics", 0) == 0) {
+        MetricsRegistry::global().writeText(body);
+    } else {
+        status = "404 Not Found";
+        body << "Try /metrics\n";
+    }
+
+    utils::TextEncoder response{};
+    response << "HTTP/1.0 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body.view();
+
+    auto text = response.view();
+    client.write(reinterpret_cast<const std::uint8_t*>(text.data()), text.size());
+    client.close();
+}
+
+static bool defaultPacketHandler(PlayerSocket& player, const RawPacket& rawPacket) {
+    utils::Socket& client = *player.socket;
+
     switch (static_cast<PacketType>(rawPacket.id)) {
         case PacketType::INVALID:
             return true;
         case PacketType::PING: {
-            std::cout << client.getIP() << ":" << client.getPort() << " pong!" << std::endl;
+            // echoed, so the client can time the round trip
+            queuePacket(client, PingPacket{rawPacket});
             return true;
         }
         case PacketType::USERNAMES:
@@ -174,8 +701,8 @@ static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPack
         case PacketType::LOGIN: {
             LoginPacket login{rawPacket};
             std::cout << "Username: " << login.username << " - Version: " << (std::string) login.version << std::endl;
-            writePacket(client, PlayerPacket{login.version, 0, 0, 0, 0, 10, 10, 0, 0, ItemMaterial::NULL_MATERIAL, 0, 0, {}, {}, false, {}});
-            writePacket(client, InitPacket{12, 128, 128, 0, 0, 0});
+            queuePacket(client, PlayerPacket{login.version, 0, 0, 0, 0, 10, 10, 0, 0, ItemMaterial::NULL_MATERIAL, 0, 0, {}, {}, false, {}});
+            queuePacket(client, InitPacket{12, Server::LEVEL_SIZE, Server::LEVEL_SIZE, 0, 0, 0});
 
             return true;
         }
@@ -184,9 +711,13 @@ static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPack
         case PacketType::INIT:
             return true;
         case PacketType::LOAD: {
-            writePacket(client, TilesPacket{std::vector<Tile>(128*128)});
-            writePacket(client, EntitiesPacket{std::vector<std::shared_ptr<Entity>>{}});
-            writePacket(client, GamePacket("survival", 6000, 1, true, 10, 1, 1));
+            LoadPacket load{rawPacket};
+            if (!isLevel(load.currentLevel)) {
+                return false;
+            }
+            player.setLocation(Location2f{static_cast<WorldId>(load.currentLevel), 0, 0});
+            // the level may be ticking on another thread right now, the tiles are read between ticks
+            player.pendingLoad = static_cast<WorldId>(load.currentLevel);
 
             return true;
         }
@@ -202,6 +733,11 @@ static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPack
             return false;
         case PacketType::MOVE: {
             MovePacket move{rawPacket};
+            // a level the server doesn't have would leave the player out of every view update
+            if (!isLevel(move.world)) {
+                return false;
+            }
+            player.setLocation(Location2f{move.world, move.location, move.direction});
 
             return true;
         }
@@ -219,10 +755,15 @@ static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPack
             return false;
         case PacketType::INTERACT:
             return true;
-        case PacketType::PUSH:
-            return true;
-        case PacketType::PICKUP:
-            return true;
+        case PacketType::PUSH: {
+            // an id from before the entity died may belong to a new one by now
+            PushPacket push{rawPacket};
+            return EntityIdAllocator::global().isAlive(push.entity);
+        }
+        case PacketType::PICKUP: {
+            PickupPacket pickup{rawPacket};
+            return EntityIdAllocator::global().isAlive(pickup.entity);
+        }
         case PacketType::CHEST_IN:
             return true;
         case PacketType::CHEST_OUT:
@@ -247,6 +788,19 @@ static bool defaultPacketHandler(utils::Socket& client, const RawPacket& rawPack
             return true;
         case PacketType::STOPFISHING:
             return false;
+        case PacketType::EXTENSIONS: {
+            ExtensionsPacket request{rawPacket};
+
+            // we support everything we know the name of, so enable all of them
+            for (auto extension : request.extensionList) {
+                player.enableExtension(extension);
+            }
+            queuePacket(client, ExtensionsPacket{request.extensionList});
+
+            return true;
+        }
+        case PacketType::BINARY_TILES:
+            return false;
     }
 
     return false;
@@ -267,9 +821,154 @@ static std::unordered_map<std::string, std::shared_ptr<CommandExecutor>> default
         }
     };
 
+    class SaveCommand : public CommandExecutor {
+    public:
+        void execute(IServer& server, const mcplus::Sender& sender, const std::vector<std::string>& args) override {
+            sender.sendMessage("Saving worlds");
+            dynamic_cast<Server&>(server).requestSave();
+        }
+    };
+
+    class TpsCommand : public CommandExecutor {
+    public:
+        void execute(IServer& server, const mcplus::Sender& sender, const std::vector<std::string>& args) override {
+            auto statistics = dynamic_cast<Server&>(server).getTickStatistics();
+
+            utils::TextEncoder encoder{};
+            encoder << "TPS: " << statistics.tps
+                    << " - Tick: " << statistics.meanMillis << "ms mean, " << statistics.p99Millis << "ms p99"
+                    << " - Overruns: " << statistics.overruns << '/' << statistics.ticks
+                    << " - Skipped: " << statistics.skipped;
+            sender.sendMessage(encoder.take());
+        }
+    };
+
+    class InboundCommand : public CommandExecutor {
+    public:
+        void execute(IServer& server, const mcplus::Sender& sender, const std::vector<std::string>& args) override {
+            auto& minicraftServer = dynamic_cast<Server&>(server);
+
+            for (const auto& statistics : minicraftServer.getInboundStatistics()) {
+                utils::TextEncoder encoder{};
+                encoder << "World " << statistics.world
+                        << " - Queued: " << statistics.queued << '/' << statistics.capacity
+                        << " - Dropped: " << statistics.dropped;
+                sender.sendMessage(encoder.take());
+            }
+            for (const auto& statistics : minicraftServer.getBusiestConnections(5)) {
+                utils::TextEncoder encoder{};
+                encoder << statistics.address
+                        << " - Received: " << statistics.received
+                        << " - Dropped: " << statistics.dropped;
+                sender.sendMessage(encoder.take());
+            }
+
+            auto buffers = utils::BufferPool::global().getStatistics();
+            utils::TextEncoder encoder{};
+            encoder << "Packet buffers - Reused: " << buffers.reused << '/' << buffers.acquired
+                    << " - Released: " << buffers.released;
+            sender.sendMessage(encoder.take());
+        }
+    };
+
+    class ChunksCommand : public CommandExecutor {
+    public:
+        void execute(IServer& server, const mcplus::Sender& sender, const std::vector<std::string>& args) override {
+            auto& minicraftServer = dynamic_cast<Server&>(server);
+            if (args.size() == 2 && args[0] == "budget") {
+                // in MiB per level, 0 for no limit
+                bool number = !args[1].empty() && std::all_of(args[1].begin(), args[1].end(), [](char c) { return c >= '0' && c <= '9'; });
+                if (!number) {
+                    sender.sendMessage("Usage: chunks budget <MiB per level>");
+                    return;
+                }
+                minicraftServer.setChunkBudget(utils::parseNumber<std::size_t>(args[1]) * 1024 * 1024);
+            }
+
+            auto statistics = minicraftServer.getChunkIOStatistics();
+
+            utils::TextEncoder encoder{};
+            encoder << "Chunks memory: " << minicraftServer.getChunkMemory() / 1024 << " KiB"
+                    << " (budget " << minicraftServer.getChunkBudget() / 1024 / 1024 << " MiB per level)"
+                    << " - Loading: " << minicraftServer.getLoadingChunks()
+                    << " - Reads: " << statistics.reads << " (" << statistics.queuedReads << " queued)"
+                    << " - Writes: " << statistics.writes << " (" << statistics.queuedWrites << " queued)"
+                    << " - Failures: " << statistics.failures;
+            sender.sendMessage(encoder.take());
+        }
+    };
+
+    class MetricsCommand : public CommandExecutor {
+        // microseconds with one decimal
+        static double micros(std::uint64_t nanos) {
+            return static_cast<double>(nanos / 100) / 10;
+        }
+    public:
+        void execute(IServer& server, const mcplus::Sender& sender, const std::vector<std::string>& args) override {
+            if (!args.empty() && args[0] == "prometheus") {
+                utils::TextEncoder encoder{};
+                MetricsRegistry::global().writeText(encoder);
+                sender.sendMessage(encoder.take());
+                return;
+            }
+
+            struct Row {
+                const PacketMetrics::Type* type;
+                Histogram::Snapshot decode;
+                Histogram::Snapshot handle;
+            };
+
+            auto& metrics = PacketMetrics::global();
+            std::vector<Row> rows{};
+            std::uint64_t totalNanos = 0;
+            for (std::size_t id = 0; id < 256; id++) {
+                const auto& type = metrics.getType(static_cast<PacketId>(id));
+                // unknown ids all share the same metrics, list them once
+                bool listed = std::any_of(rows.begin(), rows.end(), [&type](const Row& row) { return row.type->received == type.received; });
+                if (listed || (type.received->get() == 0 && type.sent->get() == 0)) {
+                    continue;
+                }
+
+                rows.push_back({&type, type.decode->snapshot(), type.handle->snapshot()});
+                totalNanos += rows.back().handle.sum;
+            }
+
+            // the packets costing the tick the most first
+            std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+                return a.handle.sum > b.handle.sum;
+            });
+
+            for (const auto& row : rows) {
+                const auto& type = *row.type;
+
+                utils::TextEncoder encoder{};
+                encoder << type.name
+                        << " - In: " << type.received->get() << " (" << type.receivedBytes->get() / 1024 << " KiB)"
+                        << " - Out: " << type.sent->get() << " (" << type.sentBytes->get() / 1024 << " KiB)"
+                        << " - Bad: " << type.bad->get()
+                        << " - Decode p99: " << micros(row.decode.valueAt(0.99)) << " us"
+                        << " - Handle p50/p99: " << micros(row.handle.valueAt(0.5)) << '/' << micros(row.handle.valueAt(0.99)) << " us"
+                        << " - Total: " << micros(row.handle.sum) / 1000 << " ms";
+                if (totalNanos > 0) {
+                    encoder << " (" << row.handle.sum * 100 / totalNanos << "%)";
+                }
+                sender.sendMessage(encoder.take());
+            }
+
+            utils::TextEncoder encoder{};
+            encoder << "Bad frames: " << metrics.getBadFrames();
+            sender.sendMessage(encoder.take());
+        }
+    };
+
     static std::unordered_map<std::string, std::shared_ptr<CommandExecutor>> _data{
         {"stop", std::make_shared<StopCommand>()},
-        {"ping", std::make_shared<PingCommand>()}
+        {"ping", std::make_shared<PingCommand>()},
+        {"save", std::make_shared<SaveCommand>()},
+        {"tps", std::make_shared<TpsCommand>()},
+        {"inbound", std::make_shared<InboundCommand>()},
+        {"chunks", std::make_shared<ChunksCommand>()},
+        {"metrics", std::make_shared<MetricsCommand>()}
     };
 
     return _data;
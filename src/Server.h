@@ -1,44 +1,148 @@
 #ifndef MINICRAFTSERVER_SERVER_H
 #define MINICRAFTSERVER_SERVER_H
 
+#include <atomic>
 #include <string>
 #include <thread>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <functional>
+#include <optional>
 
 #include "MinicraftDef.h"
 #include "Socket.h"
 #include "World.h"
 #include "Protocol.h"
+#include "Packet.h"
+#include "Reactor.h"
+#include "InterestManager.h"
+#include "TickScheduler.h"
+#include "JobSystem.h"
+#include "ChunkIO.h"
+#include "WorldGenerator.h"
+#include "MpscQueue.h"
 #include "Event.h"
 
 namespace mcplus {
 
+    class PlayerSocket;
+
+    using PlayerPacketHandler = std::function<bool(PlayerSocket&, const RawPacket&)>;
+
     class PlayerSocket {
-        std::thread* thread;
-        PacketHandler packetHandler;
+        PlayerPacketHandler packetHandler;
+        int badPackets;
+        uint32_t extensions;
+
+        // written by the I/O thread, read by the tick
+        mutable std::mutex locationMutex;
+        std::optional<Location2f> location;
     public:
         std::shared_ptr<utils::Socket> socket;
+        // the world whose InterestManager has this player, only touched by the tick
+        std::optional<WorldId> viewWorld;
+        // where the player was when it last moved, when that was and the chunks
+        // prefetched for it then, only touched by the tick
+        std::optional<Location2f> previousLocation;
+        std::uint64_t previousMoveTick;
+        Vector2i prefetchedChunk;
+        Vector2i predictedChunk;
+        // the view window this player keeps loaded, only touched by the tick
+        std::optional<WorldId> heldWorld;
+        Vector2i heldChunk;
+        // the level a LOAD asked for, set while handling the player's packets
+        // and answered with its tiles by updateViews()
+        std::optional<WorldId> pendingLoad;
+
+        // the world whose inbound queue takes this player's packets, held while pushing to it or changing it
+        std::mutex routeMutex;
+        WorldId inboundWorld;
+        // backpressure: packets read from the player, and the ones dropped on a full queue
+        std::atomic<std::uint64_t> receivedPackets;
+        std::atomic<std::uint64_t> droppedPackets;
 
         explicit PlayerSocket(std::shared_ptr<utils::Socket> socket);
-        ~PlayerSocket();
 
-        virtual void run();
+        void handle(const RawPacket& rawPacket);
 
-        void start();
         [[nodiscard]] bool isConnected() const;
+
+        [[nodiscard]] bool hasExtension(Extension extension) const;
+        void enableExtension(Extension extension);
+
+        /**
+         * Where the player is, empty until it loaded a world.
+         */
+        [[nodiscard]] std::optional<Location2f> getLocation() const;
+        void setLocation(const Location2f& location);
+    };
+
+    struct InboundPacket {
+        std::shared_ptr<PlayerSocket> player;
+        RawPacket packet;
+    };
+
+    /**
+     * Packets read by the I/O threads for the players of one world, handled
+     * by the tick before the world ticks. Order is kept per player.
+     */
+    struct InboundQueue {
+        static constexpr std::size_t CAPACITY = 4096;
+
+        MpscQueue<InboundPacket> queue;
+        std::atomic<std::uint64_t> dropped;
+
+        InboundQueue();
     };
 
     class Server : public IServer {
+    public:
+        // Prometheus text on http://127.0.0.1:METRICS_PORT/metrics
+        static constexpr std::uint16_t METRICS_PORT = 9225;
+        // chunks are read ahead for where a player will be in a second, at most that many chunks away
+        static constexpr int PREFETCH_TICKS = 60;
+        static constexpr int PREFETCH_STEPS = 8;
+        // dirty chunks go to disk every 30 seconds
+        static constexpr std::uint64_t WRITE_BACK_TICKS = 60 * 30;
+        // chunk memory of each level before the ones out of view get unloaded
+        static constexpr std::size_t DEFAULT_CHUNK_BUDGET = 64 * 1024 * 1024;
+        // tiles a side of the map the clients are told about, and of the area generated at startup
+        static constexpr int LEVEL_SIZE = 128;
+        static constexpr int PREGENERATE_SIZE = 1024;
+    private:
         std::unique_ptr<utils::SocketServer> socketServer;
-        bool running;
+        std::unique_ptr<utils::SocketServer> metricsServer;
+        std::unique_ptr<Reactor> reactor;
+        std::unique_ptr<TickScheduler> scheduler;
+        std::unique_ptr<JobSystem> jobs;
+        // before chunkIO, its reads generate the chunks missing from disk
+        WorldGenerator generator;
+        std::unique_ptr<ChunkIO> chunkIO;
+        std::atomic<bool> running;
+        std::uint64_t tickCount;
+        // summed up by every tick for the console
+        std::atomic<std::size_t> loadingChunks;
+        std::atomic<std::size_t> chunkMemory;
+        // per level, set from the console and given to the worlds by the tick
+        std::atomic<std::size_t> chunkBudget;
+        // set by the save command, the next tick saves between two ticks
+        std::atomic<bool> saveRequested;
 
         std::unordered_map<WorldId, World> worldMap;
-        std::vector<PlayerSocket> socketList;
+        std::unordered_map<WorldId, InterestManager> interestMap;
+        std::unordered_map<WorldId, std::unique_ptr<InboundQueue>> inboundMap;
+        std::mutex socketMutex;
+        std::vector<std::shared_ptr<PlayerSocket>> socketList;
+        // gone, but still holding their view window until the tick releases it
+        std::vector<std::shared_ptr<PlayerSocket>> leftPlayers;
         std::vector<EventListener> listenerList;
         std::unordered_map<std::string, std::shared_ptr<CommandExecutor>> commandMap;
+
+        // rebuilt every tick, kept to reuse their storage
+        std::vector<JobSystem::Job> worldJobs;
+        std::vector<EntityId> departures;
     public:
         Server(const std::string& ip, short port);
 
@@ -48,13 +152,108 @@ namespace mcplus {
         const World& getWorld(WorldId id) const;
         World& getWorld(WorldId id);
 
+        /**
+         * Keeps every level in worlds/<worldName>/<level>, with the seed of
+         * the terrain in worlds/<worldName>/seed. Chunks are read from there
+         * when first loaded, the ones around the spawn right now, and the
+         * ones never saved are generated from the seed. Items left on the
+         * ground at the last save are put back.
+         */
         void loadWorld(const std::string& worldName);
+        /**
+         * Saves a level to its region files, if it has some, and waits until
+         * it is on disk.
+         */
         void unloadWorld(WorldId id);
 
+        /**
+         * Writes back every level on the next tick, while no world is ticking.
+         */
+        void requestSave();
+        /**
+         * Snapshots the dirty chunks and items of every level with region
+         * files for the ChunkIO writer, returns how many chunks. Only
+         * between ticks, the worlds go on ticking while it is written.
+         */
+        std::size_t writeBackWorlds();
+
         bool dispatchCommand(const std::string& command);
 
         void run();
 
+        /**
+         * Moves every player's view window to where it is now, subscribing
+         * it to another world's InterestManager when it changed level.
+         */
+        void updateViews();
+
+        /**
+         * Requests the chunks in view of a player that moved, and the ones
+         * on its way, so they are read before it gets there.
+         */
+        void prefetchChunks(PlayerSocket& player, const Location2f& location);
+        /**
+         * Moves the view window a player keeps loaded to where it is, none
+         * for an empty location.
+         */
+        void holdChunks(PlayerSocket& player, const std::optional<Location2f>& location);
+        /**
+         * Sends the LEVEL_SIZE x LEVEL_SIZE tiles of a level, then its
+         * entities and the game settings, like a LOAD expects. False, with
+         * nothing sent, while chunks of it are still being loaded.
+         */
+        bool sendLevel(PlayerSocket& player, WorldId level);
+
+        /**
+         * Moves the entities that changed level during the last tick into
+         * their new world. Runs between ticks, while no world is ticking.
+         */
+        void transferEntities();
+
+        /**
+         * Called by the I/O threads for every complete frame, queues it for
+         * the world the player is in. Drops it when the queue is full.
+         */
+        void receive(const std::shared_ptr<PlayerSocket>& player, RawPacket& rawPacket);
+
+        /**
+         * Handles every packet queued for a world. Only one thread at a time
+         * may drain a given world.
+         */
+        void drainInbound(WorldId id);
+
+        [[nodiscard]] TickScheduler::Statistics getTickStatistics() const;
+        [[nodiscard]] ChunkIO::Statistics getChunkIOStatistics() const;
+        /**
+         * Chunks requested but not read yet, all levels together.
+         */
+        [[nodiscard]] std::size_t getLoadingChunks() const;
+        /**
+         * Loaded chunk memory of all levels, as of their last eviction check.
+         */
+        [[nodiscard]] std::size_t getChunkMemory() const;
+        [[nodiscard]] std::size_t getChunkBudget() const;
+        void setChunkBudget(std::size_t bytes);
+
+        struct InboundStatistics {
+            WorldId world;
+            std::size_t queued;
+            std::size_t capacity;
+            std::uint64_t dropped;
+        };
+
+        struct ConnectionStatistics {
+            std::string address;
+            std::uint64_t received;
+            std::uint64_t dropped;
+        };
+
+        [[nodiscard]] std::vector<InboundStatistics> getInboundStatistics() const;
+        /**
+         * The connections that dropped the most packets, then read the most.
+         */
+        [[nodiscard]] std::vector<ConnectionStatistics> getBusiestConnections(std::size_t limit);
+
         bool isShutdown() const override;
         void shutdown() override;
     };
@@ -1,9 +1,16 @@
 #include "Socket.h"
+#include "Utils.h"
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
+#include <climits>
+#include <cerrno>
 #include <stdexcept>
+#include <vector>
 
 using namespace mcplus::utils;
 
@@ -11,6 +18,28 @@ SocketServer::SocketServer(std::uint16_t port, std::uint32_t listen) {
     this->sock       = 0;
     this->port       = port;
     this->listenSock = listen;
+    this->address    = INADDR_ANY;
+
+    try {
+        bindConnection();
+    } catch (const std::exception& e) {
+        if (this->sock != 0) {
+            shutdown(this->sock, SHUT_RDWR);
+        }
+        throw;
+    }
+}
+
+SocketServer::SocketServer(const std::string& IP, std::uint16_t port, std::uint32_t listen) {
+    this->sock       = 0;
+    this->port       = port;
+    this->listenSock = listen;
+
+    in_addr parsed{};
+    if (inet_pton(AF_INET, IP.c_str(), &parsed) <= 0) {
+        throw std::logic_error("Invalid address");
+    }
+    this->address = parsed.s_addr;
 
     try {
         bindConnection();
@@ -36,8 +65,14 @@ void SocketServer::bindConnection() {
         throw std::logic_error("Error to create socket");
     }
 
+    // restarting right after a stop must not wait for the old connections to time out
+    int reuse = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        throw std::logic_error("Error to set SO_REUSEADDR");
+    }
+
     serv_addr.sin_family      = AF_INET;
-    serv_addr.sin_addr.s_addr = INADDR_ANY;
+    serv_addr.sin_addr.s_addr = address;
     serv_addr.sin_port        = htons(this->port);
 
     if (bind(sock, (sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
@@ -63,6 +98,10 @@ Socket::Socket(const std::string& IP, std::uint16_t port) {
     this->IP   = IP;
     this->port = port;
     this->connected = false;
+    this->sendOffset = 0;
+    this->queuedBytes = 0;
+    this->sendVectors = {};
+    this->writeCalls = 0;
 
     try {
         bindConnection();
@@ -85,10 +124,19 @@ Socket::Socket(int sock) {
     this->port = ntohs(serv_addr.sin_port);
 
     this->connected = true;
+    this->sendOffset = 0;
+    this->queuedBytes = 0;
+    this->sendVectors = {};
+    this->writeCalls = 0;
 }
 
 Socket::~Socket() {
     close();
+
+    // the descriptor is only released here, so it can't be reused while anyone still holds this socket
+    if (this->sock != 0) {
+        ::close(this->sock);
+    }
 }
 
 void Socket::bindConnection() {
@@ -116,8 +164,38 @@ std::uint16_t Socket::getPort() const {
     return this->port;
 }
 
+int Socket::getDescriptor() const {
+    return this->sock;
+}
+
+void Socket::setBlocking(bool blocking) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) {
+        throw std::logic_error("Socket::setBlocking(): Error to get flags");
+    }
+
+    flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    if (fcntl(sock, F_SETFL, flags) < 0) {
+        throw std::logic_error("Socket::setBlocking(): Error to set flags");
+    }
+}
+
+// a non-blocking socket may refuse to send, so wait until the kernel has room again
+static bool waitWritable(int sock) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+    }
+
+    pollfd descriptor{.fd = sock, .events = POLLOUT, .revents = 0};
+    return poll(&descriptor, 1, -1) > 0;
+}
+
 void Socket::write(uint8_t byte) const {
-    std::size_t result = send(sock, &byte, sizeof(uint8_t), 0);
+    ssize_t result = send(sock, &byte, sizeof(uint8_t), MSG_NOSIGNAL);
+    while (result == -1 && waitWritable(sock)) {
+        result = send(sock, &byte, sizeof(uint8_t), MSG_NOSIGNAL);
+    }
+
     if (result == -1) {
         this->connected = false;
         throw std::logic_error("Error to send sock");
@@ -125,11 +203,18 @@ void Socket::write(uint8_t byte) const {
 }
 
 void Socket::write(std::unique_ptr<std::uint8_t[]> bytes, std::size_t len) const {
+    write(bytes.get(), len);
+}
+
+void Socket::write(const std::uint8_t* bytes, std::size_t len) const {
     std::size_t left = len;
 
     // make sure to send the whole data
     while (left > 0) {
-        int result = send(sock, bytes.get() + (len - left), sizeof(uint8_t) * left, 0);
+        ssize_t result = send(sock, bytes + (len - left), sizeof(uint8_t) * left, MSG_NOSIGNAL);
+        if (result == -1 && waitWritable(sock)) {
+            continue;
+        }
         if (result == -1) {
             this->connected = false;
             throw std::logic_error("Error to send sock");
@@ -164,6 +249,121 @@ std::unique_ptr<uint8_t[]> Socket::read(std::size_t len) const {
     return std::move<>(bytes);
 }
 
+std::size_t Socket::readSome(std::uint8_t* bytes, std::size_t len) const {
+    iovec vector{.iov_base = bytes, .iov_len = len};
+    return readSome(&vector, 1);
+}
+
+std::size_t Socket::readSome(const iovec* vectors, int count) const {
+    ssize_t result = readv(sock, vectors, count);
+    if (result > 0) {
+        return result;
+    }
+    if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+
+    this->connected = false;
+    throw std::logic_error(result == 0 ? "Socket::readSome(): Connection closed by peer" : "Socket::readSome(): Error to receive sock");
+}
+
+void Socket::clearQueue() {
+    for (auto& frame : sendQueue) {
+        BufferPool::global().release(std::move(frame.data));
+    }
+    sendQueue.clear();
+    sendOffset  = 0;
+    queuedBytes = 0;
+}
+
+void Socket::enqueue(std::uint8_t id, std::string data) {
+    std::lock_guard<std::mutex> lock{sendMutex};
+    if (!connected) {
+        BufferPool::global().release(std::move(data));
+        return;
+    }
+
+    queuedBytes += data.size() + 2;
+    sendQueue.push_back({id, std::move(data)});
+    if (queuedBytes > MAX_QUEUED_BYTES) {
+        // rather than keep queueing for a client that doesn't read
+        clearQueue();
+        close();
+    }
+}
+
+bool Socket::flush() {
+    static const char terminator = '\0';
+
+    std::lock_guard<std::mutex> lock{sendMutex};
+    if (sendQueue.empty()) {
+        return true;
+    }
+
+    auto& vectors = sendVectors;
+
+    while (!sendQueue.empty()) {
+        vectors.clear();
+
+        // every frame is id + data + terminator, the front one may be partially sent
+        std::size_t skip = sendOffset;
+        for (auto it = sendQueue.begin(); it != sendQueue.end() && vectors.size() + 3 <= IOV_MAX; ++it) {
+            iovec parts[3] = {
+                    {.iov_base = &it->id, .iov_len = 1},
+                    {.iov_base = it->data.data(), .iov_len = it->data.size()},
+                    {.iov_base = const_cast<char*>(&terminator), .iov_len = 1}
+            };
+
+            for (auto& part : parts) {
+                if (skip >= part.iov_len) {
+                    skip -= part.iov_len;
+                    continue;
+                }
+
+                part.iov_base = static_cast<char*>(part.iov_base) + skip;
+                part.iov_len -= skip;
+                skip = 0;
+                vectors.push_back(part);
+            }
+        }
+
+        writeCalls++;
+        ssize_t result = writev(sock, vectors.data(), static_cast<int>(vectors.size()));
+        if (result == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+
+            this->connected = false;
+            throw std::logic_error("Socket::flush(): Error to send sock");
+        }
+
+        // drop whatever got completely sent
+        auto sent = static_cast<std::size_t>(result) + sendOffset;
+        while (!sendQueue.empty() && sent >= sendQueue.front().data.size() + 2) {
+            sent -= sendQueue.front().data.size() + 2;
+            queuedBytes -= sendQueue.front().data.size() + 2;
+            BufferPool::global().release(std::move(sendQueue.front().data));
+            sendQueue.pop_front();
+        }
+        sendOffset = sent;
+    }
+
+    return true;
+}
+
+bool Socket::hasPending() {
+    std::lock_guard<std::mutex> lock{sendMutex};
+    return !sendQueue.empty();
+}
+
+std::uint64_t Socket::getWriteCalls() const {
+    return writeCalls;
+}
+
 bool Socket::isConnected() const {
     return this->connected;
 }
@@ -173,7 +373,6 @@ void Socket::close() {
         shutdown(this->sock, SHUT_RDWR);
     }
     this->connected = false;
-    this->sock = 0;
 }
 
 void mcplus::utils::writeString(const Socket& socket, const std::string& string) {
@@ -195,14 +394,8 @@ std::string mcplus::utils::readString(const Socket& socket) {
 }
 
 void mcplus::utils::writeLegacyString(const Socket& socket, const std::string& string) {
-    std::size_t length = string.size() + 1;
-    std::unique_ptr<uint8_t[]> bytes = std::make_unique<uint8_t[]>(length);
-
-    for (std::size_t i = 0; i < length; i++) {
-        bytes[i] = i + 1 < length ? string[i] : '\0';
-    }
-
-    socket.write(std::move(bytes), length);
+    // c_str() is already terminated, so it can be sent as it is
+    socket.write(reinterpret_cast<const uint8_t*>(string.c_str()), string.size() + 1);
 }
 
 std::string mcplus::utils::readLegacyString(const Socket& socket) {
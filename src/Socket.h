@@ -1,11 +1,16 @@
 #ifndef MINICRAFTSERVER_SOCKET_H
 #define MINICRAFTSERVER_SOCKET_H
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <arpa/inet.h>
+#include <sys/uio.h>
 
 namespace mcplus::utils {
 
@@ -18,21 +23,45 @@ namespace mcplus::utils {
 
         std::uint16_t port;
         std::uint32_t listenSock;
+        in_addr_t address;
 
         void bindConnection();
     public:
         SocketServer(std::uint16_t port, std::uint32_t listen);
+        /**
+         * Only accepts connections made to IP, like 127.0.0.1 for local ones.
+         */
+        SocketServer(const std::string& IP, std::uint16_t port, std::uint32_t listen);
         ~SocketServer();
 
         [[nodiscard]] std::shared_ptr<Socket> acceptSock() const;
     };
 
     class Socket {
+    public:
+        // a peer that lets this much pile up stopped reading, it's disconnected
+        static constexpr std::size_t MAX_QUEUED_BYTES = 4 * 1024 * 1024;
+    private:
+        struct PendingFrame {
+            std::uint8_t id;
+            std::string data;
+        };
+
         int sock;
         std::string IP;
         std::uint16_t port;
 
-        mutable bool connected;
+        // written by whichever thread sees the connection fail, read by all
+        mutable std::atomic<bool> connected;
+
+        std::mutex sendMutex;
+        std::deque<PendingFrame> sendQueue;
+        std::size_t sendOffset; // bytes of the front frame already sent
+        std::size_t queuedBytes;
+        std::vector<iovec> sendVectors;
+        std::atomic<std::uint64_t> writeCalls;
+
+        void clearQueue();
 
         void bindConnection();
     public:
@@ -42,13 +71,44 @@ namespace mcplus::utils {
 
         const std::string& getIP() const;
         std::uint16_t getPort() const;
+        int getDescriptor() const;
+
+        void setBlocking(bool blocking);
 
         void write(std::uint8_t byte) const;
         void write(std::unique_ptr<std::uint8_t[]> bytes, std::size_t len) const;
+        void write(const std::uint8_t* bytes, std::size_t len) const;
 
         std::uint8_t read() const;
         std::unique_ptr<std::uint8_t[]> read(std::size_t len) const;
 
+        /**
+         * Reads whatever is available without blocking, up to len bytes.
+         *
+         * Returns 0 when the socket would block, throws if the peer closed
+         * the connection or the socket failed.
+         */
+        std::size_t readSome(std::uint8_t* bytes, std::size_t len) const;
+        std::size_t readSome(const iovec* vectors, int count) const;
+
+        /**
+         * Queues a legacy frame (id, data and '\0' terminator) without copying data,
+         * it's sent by the next flush() and data goes back to the BufferPool.
+         * Past MAX_QUEUED_BYTES the queue is dropped and the socket closed.
+         */
+        void enqueue(std::uint8_t id, std::string data);
+
+        /**
+         * Sends every queued frame with as few writev calls as possible.
+         *
+         * Returns false if a non-blocking socket couldn't take everything,
+         * the rest stays queued for the next flush.
+         */
+        bool flush();
+
+        [[nodiscard]] bool hasPending();
+        [[nodiscard]] std::uint64_t getWriteCalls() const;
+
         bool isConnected() const;
         void close();
     };
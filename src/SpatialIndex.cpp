@@ -0,0 +1,106 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mcplus;
+
+SpatialHash::SpatialHash(float cellSize) {
+    this->cellSize        = cellSize;
+    this->inverseCellSize = 1 / cellSize;
+    this->cells           = {};
+    this->entryCount      = 0;
+}
+
+Vector2i SpatialHash::cellOf(const Vector2f& position) const {
+    return {static_cast<int>(std::floor(position.x * inverseCellSize)),
+            static_cast<int>(std::floor(position.y * inverseCellSize))};
+}
+
+uint64_t SpatialHash::keyOf(const Vector2i& cell) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32 | static_cast<uint32_t>(cell.y);
+}
+
+void SpatialHash::insert(EntityId id, const Vector2f& position) {
+    cells[keyOf(cellOf(position))].push_back({id, position});
+    entryCount++;
+}
+
+bool SpatialHash::remove(EntityId id, const Vector2f& position) {
+    auto it = cells.find(keyOf(cellOf(position)));
+    if (it == cells.end()) {
+        return false;
+    }
+
+    auto& cell = it->second;
+    auto entry = std::find_if(cell.begin(), cell.end(), [id](const Entry& entry) { return entry.id == id; });
+    if (entry == cell.end()) {
+        return false;
+    }
+
+    // order inside a cell doesn't matter, swap with the last one
+    *entry = cell.back();
+    cell.pop_back();
+    entryCount--;
+
+    if (cell.empty()) {
+        cells.erase(it);
+    }
+
+    return true;
+}
+
+void SpatialHash::move(EntityId id, const Vector2f& from, const Vector2f& to) {
+    Vector2i fromCell = cellOf(from);
+    Vector2i toCell   = cellOf(to);
+
+    if (fromCell == toCell) {
+        auto it = cells.find(keyOf(fromCell));
+        if (it != cells.end()) {
+            for (auto& entry : it->second) {
+                if (entry.id == id) {
+                    entry.position = to;
+                    return;
+                }
+            }
+        }
+    } else if (remove(id, from)) {
+        insert(id, to);
+    }
+}
+
+bool SpatialHash::moveWithinCell(EntityId id, const Vector2f& from, const Vector2f& to) {
+    Vector2i cell = cellOf(from);
+    if (cell != cellOf(to)) {
+        return false;
+    }
+
+    auto it = cells.find(keyOf(cell));
+    if (it != cells.end()) {
+        for (auto& entry : it->second) {
+            if (entry.id == id) {
+                entry.position = to;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void SpatialHash::clear() {
+    cells.clear();
+    entryCount = 0;
+}
+
+std::size_t SpatialHash::size() const {
+    return entryCount;
+}
+
+void SpatialHash::query(const Rectangle2f& area, std::vector<EntityId>& result) const {
+    forEachIn(area, [&result](const Entry& entry) { result.push_back(entry.id); });
+}
+
+void SpatialHash::query(const Circle2f& area, std::vector<EntityId>& result) const {
+    forEachIn(area, [&result](const Entry& entry) { result.push_back(entry.id); });
+}
@@ -0,0 +1,106 @@
+#ifndef MINICRAFTSERVER_SPATIALINDEX_H
+#define MINICRAFTSERVER_SPATIALINDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "MinicraftDef.h"
+#include "Dimension.h"
+
+namespace mcplus {
+
+    /**
+     * Uniform grid over a world's entities. Every cell keeps the id and the
+     * position of the entities inside it, so queries only look at the cells
+     * overlapping the area and never touch the entities themselves.
+     */
+    class SpatialHash {
+    public:
+        // one chunk, an entity rarely leaves its cell in a single tick
+        static constexpr float DEFAULT_CELL_SIZE = 16;
+
+        struct Entry {
+            EntityId id;
+            Vector2f position;
+        };
+    private:
+        float cellSize;
+        float inverseCellSize;
+        std::unordered_map<uint64_t, std::vector<Entry>> cells;
+        std::size_t entryCount;
+
+        [[nodiscard]] Vector2i cellOf(const Vector2f& position) const;
+        static uint64_t keyOf(const Vector2i& cell);
+
+        template<typename F>
+        void forEachCandidate(float minX, float minY, float maxX, float maxY, F&& function) const {
+            Vector2i min = cellOf({minX, minY});
+            Vector2i max = cellOf({maxX, maxY});
+
+            for (int y = min.y; y <= max.y; y++) {
+                for (int x = min.x; x <= max.x; x++) {
+                    auto it = cells.find(keyOf({x, y}));
+                    if (it == cells.end()) {
+                        continue;
+                    }
+
+                    for (const auto& entry : it->second) {
+                        function(entry);
+                    }
+                }
+            }
+        }
+    public:
+        explicit SpatialHash(float cellSize = DEFAULT_CELL_SIZE);
+
+        void insert(EntityId id, const Vector2f& position);
+        bool remove(EntityId id, const Vector2f& position);
+        /**
+         * Moves an entity already in the index, from where it was last
+         * inserted or moved to.
+         */
+        void move(EntityId id, const Vector2f& from, const Vector2f& to);
+        /**
+         * Same as move() when the entity stays in its cell, and returns
+         * false without doing anything when it doesn't. No cell is added or
+         * removed, so different entities can be moved from several threads.
+         */
+        bool moveWithinCell(EntityId id, const Vector2f& from, const Vector2f& to);
+        void clear();
+
+        [[nodiscard]] std::size_t size() const;
+
+        /**
+         * Calls function(const Entry&) for each entity inside the area, borders included.
+         */
+        template<typename F>
+        void forEachIn(const Rectangle2f& area, F&& function) const {
+            forEachCandidate(area.x, area.y, area.x + area.width, area.y + area.height, [&](const Entry& entry) {
+                if (entry.position.x >= area.x && entry.position.x <= area.x + area.width
+                    && entry.position.y >= area.y && entry.position.y <= area.y + area.height) {
+                    function(entry);
+                }
+            });
+        }
+
+        template<typename F>
+        void forEachIn(const Circle2f& area, F&& function) const {
+            float radiusSquared = area.radius * area.radius;
+
+            forEachCandidate(area.x - area.radius, area.y - area.radius, area.x + area.radius, area.y + area.radius, [&](const Entry& entry) {
+                float dx = entry.position.x - area.x;
+                float dy = entry.position.y - area.y;
+                if (dx * dx + dy * dy <= radiusSquared) {
+                    function(entry);
+                }
+            });
+        }
+
+        void query(const Rectangle2f& area, std::vector<EntityId>& result) const;
+        void query(const Circle2f& area, std::vector<EntityId>& result) const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_SPATIALINDEX_H
@@ -0,0 +1,134 @@
+#include "TickScheduler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include <ctime>
+
+using namespace mcplus;
+
+// clock_nanosleep with an absolute deadline doesn't drift like a relative sleep_for
+static void sleepUntil(TickScheduler::Clock::time_point deadline) {
+    auto since = deadline.time_since_epoch();
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since);
+
+    timespec time{.tv_sec = static_cast<time_t>(seconds.count()),
+                  .tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(since - seconds).count())};
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {}
+}
+
+TickScheduler::TickScheduler(std::uint32_t tickRate, std::uint32_t maxCatchUp) {
+    this->tickRate   = std::max<std::uint32_t>(tickRate, 1);
+    this->period     = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / this->tickRate;
+    this->maxCatchUp = maxCatchUp;
+    this->systems    = {};
+
+    this->samples.fill(Clock::duration::zero());
+    this->sampleIndex = 0;
+    this->sampleCount = 0;
+    this->ticks       = 0;
+    this->overruns    = 0;
+    this->skipped     = 0;
+
+    this->windowStart = Clock::now();
+    this->windowTicks = 0;
+    this->tps         = 0;
+}
+
+void TickScheduler::addSystem(const std::string& name, System system) {
+    systems.push_back({name, std::move(system)});
+}
+
+void TickScheduler::tick() {
+    auto start = Clock::now();
+
+    for (auto& entry : systems) {
+        try {
+            entry.system();
+        } catch (const std::exception& exception) {
+            std::cerr << "Tick system '" << entry.name << "' failed: " << exception.what() << std::endl;
+        }
+    }
+
+    record(Clock::now() - start);
+}
+
+void TickScheduler::record(Clock::duration duration) {
+    std::lock_guard<std::mutex> lock{statisticsMutex};
+
+    samples[sampleIndex] = duration;
+    sampleIndex = (sampleIndex + 1) % SAMPLE_COUNT;
+    sampleCount = std::min(sampleCount + 1, SAMPLE_COUNT);
+
+    ticks++;
+    if (duration > period) {
+        overruns++;
+    }
+
+    windowTicks++;
+    auto now = Clock::now();
+    std::chrono::duration<double> window = now - windowStart;
+    if (window.count() >= 1.0) {
+        tps = static_cast<double>(windowTicks) / window.count();
+        windowTicks = 0;
+        windowStart = now;
+    }
+}
+
+void TickScheduler::run(const std::atomic<bool>& running) {
+    auto deadline = Clock::now();
+
+    while (running) {
+        auto now = Clock::now();
+        if (now < deadline) {
+            sleepUntil(deadline);
+            continue;
+        }
+
+        auto behind = static_cast<std::uint64_t>((now - deadline) / period);
+        if (behind > maxCatchUp) {
+            auto dropped = behind - maxCatchUp;
+            deadline += period * dropped;
+
+            {
+                std::lock_guard<std::mutex> lock{statisticsMutex};
+                skipped += dropped;
+            }
+            std::cerr << "Can't keep up! Skipping " << dropped << " ticks" << std::endl;
+        }
+
+        tick();
+        deadline += period;
+    }
+}
+
+std::uint32_t TickScheduler::getTickRate() const {
+    return tickRate;
+}
+
+TickScheduler::Statistics TickScheduler::getStatistics() const {
+    std::lock_guard<std::mutex> lock{statisticsMutex};
+
+    Statistics statistics{tps, 0, 0, ticks, overruns, skipped};
+    if (sampleCount == 0) {
+        return statistics;
+    }
+
+    std::vector<Clock::duration> sorted{samples.begin(), samples.begin() + static_cast<long>(sampleCount)};
+
+    Clock::duration total = Clock::duration::zero();
+    for (const auto& sample : sorted) {
+        total += sample;
+    }
+
+    auto p99 = sorted.begin() + static_cast<long>((sorted.size() - 1) * 99 / 100);
+    std::nth_element(sorted.begin(), p99, sorted.end());
+
+    using Millis = std::chrono::duration<double, std::milli>;
+    statistics.meanMillis = std::chrono::duration_cast<Millis>(total).count() / static_cast<double>(sampleCount);
+    statistics.p99Millis  = std::chrono::duration_cast<Millis>(*p99).count();
+
+    return statistics;
+}
@@ -0,0 +1,83 @@
+#ifndef MINICRAFTSERVER_TICKSCHEDULER_H
+#define MINICRAFTSERVER_TICKSCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mcplus {
+
+    /**
+     * Fixed-timestep game loop.
+     *
+     * Every tick runs the registered systems in registration order, then
+     * sleeps until the next deadline. When a tick overruns, the following
+     * ones run back to back to catch up, but never more than maxCatchUp of
+     * them: anything beyond that is dropped and counted as skipped.
+     */
+    class TickScheduler {
+    public:
+        using Clock  = std::chrono::steady_clock;
+        using System = std::function<void()>;
+
+        struct Statistics {
+            double tps;
+            double meanMillis;
+            double p99Millis;
+            std::uint64_t ticks;
+            std::uint64_t overruns;
+            std::uint64_t skipped;
+        };
+    private:
+        static constexpr std::size_t SAMPLE_COUNT = 256;
+
+        struct Entry {
+            std::string name;
+            System system;
+        };
+
+        std::uint32_t tickRate;
+        Clock::duration period;
+        std::uint32_t maxCatchUp;
+        std::vector<Entry> systems;
+
+        mutable std::mutex statisticsMutex;
+        std::array<Clock::duration, SAMPLE_COUNT> samples;
+        std::size_t sampleIndex;
+        std::size_t sampleCount;
+        std::uint64_t ticks;
+        std::uint64_t overruns;
+        std::uint64_t skipped;
+
+        Clock::time_point windowStart;
+        std::uint64_t windowTicks;
+        double tps;
+
+        void record(Clock::duration duration);
+    public:
+        explicit TickScheduler(std::uint32_t tickRate, std::uint32_t maxCatchUp = 5);
+
+        void addSystem(const std::string& name, System system);
+
+        /**
+         * Runs one tick right away, outside of the schedule.
+         */
+        void tick();
+
+        /**
+         * Keeps ticking on schedule until running turns false.
+         */
+        void run(const std::atomic<bool>& running);
+
+        [[nodiscard]] std::uint32_t getTickRate() const;
+        [[nodiscard]] Statistics getStatistics() const;
+    };
+
+}
+
+#endif // MINICRAFTSERVER_TICKSCHEDULER_H
@@ -1,7 +1,12 @@
 #include "Utils.h"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
 
 void mcplus::utils::splitString(const std::string& string,
                                 const std::string& delimiter,
@@ -49,3 +54,292 @@ std::string& mcplus::utils::toLower(std::string& string) {
     std::transform(string.begin(), string.end(), string.begin(), [](unsigned char c){ return std::tolower(c); });
     return string;
 }
+
+std::string mcplus::utils::cobsEncode(std::string_view data) {
+    std::string encoded{};
+    encoded.reserve(data.size() + data.size() / 254 + 1);
+
+    std::size_t codeIndex = 0;
+    uint8_t code = 1;
+    encoded.push_back(0); // placeholder for the first code
+
+    for (char byte : data) {
+        if (byte != '\0') {
+            encoded.push_back(byte);
+            code++;
+        }
+
+        if (byte == '\0' || code == 0xFF) {
+            encoded[codeIndex] = static_cast<char>(code);
+            codeIndex = encoded.size();
+            encoded.push_back(0);
+            code = 1;
+        }
+    }
+    encoded[codeIndex] = static_cast<char>(code);
+
+    return encoded;
+}
+
+std::string mcplus::utils::cobsDecode(std::string_view data) {
+    std::string decoded{};
+    decoded.reserve(data.size());
+
+    std::size_t index = 0;
+    while (index < data.size()) {
+        auto code = static_cast<uint8_t>(data[index]);
+        if (code == 0 || index + code > data.size()) {
+            throw std::runtime_error("cobsDecode: malformed data");
+        }
+
+        decoded.append(data.data() + index + 1, code - 1);
+        index += code;
+
+        if (code != 0xFF && index < data.size()) {
+            decoded.push_back('\0');
+        }
+    }
+
+    return decoded;
+}
+
+std::uint32_t mcplus::utils::crc32(std::string_view data, std::uint32_t crc) {
+    static const auto _table = []() {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < table.size(); i++) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (char character : data) {
+        crc = _table[(crc ^ static_cast<std::uint8_t>(character)) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+mcplus::utils::FieldCursor::FieldCursor(std::string_view source, char delimiter) : rest(source), delimiter(delimiter) {
+    skipDelimiters();
+}
+
+void mcplus::utils::FieldCursor::skipDelimiters() {
+    std::size_t start = rest.find_first_not_of(delimiter);
+    rest.remove_prefix(start == std::string_view::npos ? rest.size() : start);
+}
+
+std::string_view mcplus::utils::FieldCursor::next() {
+    std::size_t end = rest.find(delimiter);
+    std::string_view field = rest.substr(0, end);
+
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+    skipDelimiters();
+
+    return field;
+}
+
+bool mcplus::utils::FieldCursor::hasNext() const {
+    return !rest.empty();
+}
+
+std::size_t mcplus::utils::FieldCursor::count() const {
+    FieldCursor copy{*this};
+
+    std::size_t fields = 0;
+    for (; copy.hasNext(); copy.next()) {
+        fields++;
+    }
+    return fields;
+}
+
+std::string_view mcplus::utils::FieldCursor::remaining() const {
+    return rest;
+}
+
+mcplus::utils::TextEncoder::TextEncoder(std::size_t capacity) : buffer(BufferPool::global().acquire()) {
+    buffer.reserve(capacity);
+}
+
+namespace {
+
+    // buffers this thread can hand out without locking, the rest of the batch goes back when it exits
+    struct LocalBuffers {
+        static constexpr std::uint64_t PUBLISH_EVERY = 256;
+
+        std::vector<std::string> buffers;
+        std::uint64_t acquired = 0;
+        std::uint64_t reused   = 0;
+        std::uint64_t released = 0;
+
+        void count() {
+            if (acquired + released >= PUBLISH_EVERY) {
+                publish();
+            }
+        }
+
+        void publish() {
+            mcplus::utils::BufferPool::global().publish(acquired, reused, released);
+            acquired = reused = released = 0;
+        }
+
+        ~LocalBuffers() {
+            publish();
+            mcplus::utils::BufferPool::global().giveBatch(buffers, buffers.size());
+        }
+    };
+
+    thread_local LocalBuffers localBuffers{};
+
+}
+
+mcplus::utils::BufferPool::BufferPool() {
+    this->shared     = {};
+    this->available  = 0;
+    this->acquired   = 0;
+    this->reused     = 0;
+    this->released   = 0;
+}
+
+mcplus::utils::BufferPool& mcplus::utils::BufferPool::global() {
+    static BufferPool _pool{};
+    return _pool;
+}
+
+std::string mcplus::utils::BufferPool::acquire() {
+    auto& local = localBuffers;
+    local.acquired++;
+    local.count();
+
+    if (local.buffers.empty()) {
+        if (available.load(std::memory_order_relaxed) == 0) {
+            return {};
+        }
+        takeBatch(local.buffers, BATCH_SIZE);
+        if (local.buffers.empty()) {
+            return {};
+        }
+    }
+
+    std::string buffer = std::move(local.buffers.back());
+    local.buffers.pop_back();
+    local.reused++;
+
+    return buffer;
+}
+
+void mcplus::utils::BufferPool::release(std::string&& buffer) {
+    // short strings live inside the object, nothing to keep
+    if (buffer.capacity() > MAX_CAPACITY || buffer.capacity() <= std::string{}.capacity()) {
+        return;
+    }
+
+    auto& local = localBuffers;
+    local.released++;
+    local.count();
+
+    buffer.clear();
+    local.buffers.push_back(std::move(buffer));
+    if (local.buffers.size() >= BATCH_SIZE * 2) {
+        giveBatch(local.buffers, BATCH_SIZE);
+    }
+}
+
+void mcplus::utils::BufferPool::takeBatch(std::vector<std::string>& buffers, std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (; count > 0 && !shared.empty(); count--) {
+        buffers.push_back(std::move(shared.back()));
+        shared.pop_back();
+    }
+    available.store(shared.size(), std::memory_order_relaxed);
+}
+
+void mcplus::utils::BufferPool::giveBatch(std::vector<std::string>& buffers, std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (; count > 0 && !buffers.empty(); count--) {
+        if (shared.size() < MAX_SHARED) {
+            shared.push_back(std::move(buffers.back()));
+        }
+        buffers.pop_back();
+    }
+    available.store(shared.size(), std::memory_order_relaxed);
+}
+
+void mcplus::utils::BufferPool::publish(std::uint64_t acquiredCount, std::uint64_t reusedCount, std::uint64_t releasedCount) {
+    acquired.fetch_add(acquiredCount, std::memory_order_relaxed);
+    reused.fetch_add(reusedCount, std::memory_order_relaxed);
+    released.fetch_add(releasedCount, std::memory_order_relaxed);
+}
+
+mcplus::utils::BufferPool::Statistics mcplus::utils::BufferPool::getStatistics() const {
+    return {acquired.load(std::memory_order_relaxed),
+            reused.load(std::memory_order_relaxed),
+            released.load(std::memory_order_relaxed)};
+}
+
+mcplus::utils::TextEncoder::TextEncoder(std::string&& buffer) : buffer(std::move(buffer)) {
+    this->buffer.clear();
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(std::string_view string) {
+    buffer.append(string);
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(const std::string& string) {
+    buffer.append(string);
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(const char* string) {
+    buffer.append(string);
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(char character) {
+    buffer.push_back(character);
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(signed char character) {
+    buffer.push_back(static_cast<char>(character));
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(unsigned char character) {
+    buffer.push_back(static_cast<char>(character));
+    return *this;
+}
+
+mcplus::utils::TextEncoder& mcplus::utils::TextEncoder::operator<<(bool value) {
+    buffer.push_back(value ? '1' : '0');
+    return *this;
+}
+
+void mcplus::utils::TextEncoder::reserve(std::size_t capacity) {
+    buffer.reserve(capacity);
+}
+
+void mcplus::utils::TextEncoder::clear() {
+    buffer.clear();
+}
+
+std::size_t mcplus::utils::TextEncoder::size() const {
+    return buffer.size();
+}
+
+std::string_view mcplus::utils::TextEncoder::view() const {
+    return buffer;
+}
+
+std::string mcplus::utils::TextEncoder::take() {
+    std::string taken = std::move(buffer);
+    buffer = {};
+    return taken;
+}
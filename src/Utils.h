@@ -1,8 +1,14 @@
 #ifndef MINICRAFTSERVER_UTILS_H
 #define MINICRAFTSERVER_UTILS_H
 
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <type_traits>
 #include <vector>
 
 namespace mcplus::utils {
@@ -21,6 +27,194 @@ namespace mcplus::utils {
 
     std::string& toLower(std::string& string);
 
+    /**
+     * Consistent Overhead Byte Stuffing: rewrites binary data so it has no
+     * '\0' left (at most one extra byte every 254), which lets it travel
+     * inside a legacy null-terminated frame.
+     */
+    std::string cobsEncode(std::string_view data);
+    /**
+     * Reverses cobsEncode, throws std::runtime_error on malformed input.
+     */
+    std::string cobsDecode(std::string_view data);
+
+    /**
+     * CRC-32 (IEEE, the zlib one). Pass the previous result as crc to continue it.
+     */
+    std::uint32_t crc32(std::string_view data, std::uint32_t crc = 0);
+
+    /**
+     * Recycles the strings packet payloads live in.
+     *
+     * A payload is built by an encoder, sits in a socket's send queue and is
+     * freed once written; a read one lives until the tick handled it. With
+     * the pool both hand their buffer back instead, and the next packet
+     * reuses its capacity, so the steady state allocates nothing. Threads
+     * keep a few buffers of their own and only lock the shared list to move
+     * a batch in or out.
+     */
+    class BufferPool {
+    public:
+        // bigger buffers (a whole tile map) are rare, not worth keeping around
+        static constexpr std::size_t MAX_CAPACITY = 16 * 1024;
+        static constexpr std::size_t BATCH_SIZE   = 32;
+        static constexpr std::size_t MAX_SHARED   = 4096;
+
+        struct Statistics {
+            std::uint64_t acquired;
+            std::uint64_t reused;
+            std::uint64_t released;
+        };
+    private:
+        mutable std::mutex mutex;
+        std::vector<std::string> shared;
+        // shared.size(), readable without the lock so an empty pool costs nothing
+        std::atomic<std::size_t> available;
+        std::atomic<std::uint64_t> acquired;
+        std::atomic<std::uint64_t> reused;
+        std::atomic<std::uint64_t> released;
+
+        BufferPool();
+    public:
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        static BufferPool& global();
+
+        /**
+         * An empty string, with some capacity when one could be reused.
+         */
+        std::string acquire();
+        void release(std::string&& buffer);
+
+        /**
+         * Moves up to count buffers between the shared list and a thread's own.
+         */
+        void takeBatch(std::vector<std::string>& buffers, std::size_t count);
+        void giveBatch(std::vector<std::string>& buffers, std::size_t count);
+
+        /**
+         * Adds a thread's counts, done every few hundred buffers.
+         */
+        void publish(std::uint64_t acquiredCount, std::uint64_t reusedCount, std::uint64_t releasedCount);
+
+        /**
+         * A bit behind, threads publish their counts in chunks.
+         */
+        [[nodiscard]] Statistics getStatistics() const;
+    };
+
+    /**
+     * Parses a number the way strtol/strtof would (0 when it isn't one), but in
+     * place with std::from_chars, without needing a null-terminated copy.
+     */
+    template<typename T>
+    T parseNumber(std::string_view field) {
+        const char* first = field.data();
+        const char* last  = field.data() + field.size();
+
+        if constexpr (std::is_floating_point_v<T>) {
+            T value = 0;
+            std::from_chars(first, last, value);
+            return value;
+        } else {
+            // parse wide so "-1" still wraps into unsigned ids like strtol did
+            long long value = 0;
+            std::from_chars(first, last, value);
+            return static_cast<T>(value);
+        }
+    }
+
+    /**
+     * Walks the fields of a packet payload without copying it.
+     *
+     * Like strtok, empty fields are skipped, so "a;;b" has two fields.
+     */
+    class FieldCursor {
+        std::string_view rest;
+        char delimiter;
+
+        void skipDelimiters();
+    public:
+        FieldCursor(std::string_view source, char delimiter);
+
+        std::string_view next();
+        [[nodiscard]] bool hasNext() const;
+        [[nodiscard]] std::size_t count() const;
+        [[nodiscard]] std::string_view remaining() const;
+
+        template<typename T>
+        T nextNumber() {
+            return parseNumber<T>(next());
+        }
+    };
+
+    /**
+     * Append-only text builder for packet payloads, formatting numbers with
+     * std::to_chars instead of a locale-aware stream.
+     *
+     * It prints values exactly like std::ostream with default flags does:
+     * character types are written as raw characters, bools as 1/0 and
+     * floating points like %g with 6 significant digits.
+     */
+    class TextEncoder {
+        std::string buffer;
+
+        template<typename T>
+        TextEncoder& appendChars(T value) {
+            char digits[32];
+
+            std::to_chars_result result{};
+            if constexpr (std::is_floating_point_v<T>) {
+                result = std::to_chars(digits, digits + sizeof(digits), static_cast<double>(value), std::chars_format::general, 6);
+            } else {
+                result = std::to_chars(digits, digits + sizeof(digits), value);
+            }
+
+            buffer.append(digits, result.ptr);
+            return *this;
+        }
+    public:
+        /**
+         * Starts from a BufferPool buffer, the text taken out is expected to
+         * end up as a packet payload.
+         */
+        explicit TextEncoder(std::size_t capacity = 64);
+        /**
+         * Reuses the capacity of an existing buffer, its content is discarded.
+         */
+        explicit TextEncoder(std::string&& buffer);
+
+        TextEncoder& operator<<(std::string_view string);
+        TextEncoder& operator<<(const std::string& string);
+        TextEncoder& operator<<(const char* string);
+        TextEncoder& operator<<(char character);
+        TextEncoder& operator<<(signed char character);
+        TextEncoder& operator<<(unsigned char character);
+        TextEncoder& operator<<(bool value);
+
+        template<typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+        TextEncoder& operator<<(T value) {
+            return appendChars(value);
+        }
+
+        template<typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+        TextEncoder& operator<<(T value) {
+            return appendChars(value);
+        }
+
+        void reserve(std::size_t capacity);
+        void clear();
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::string_view view() const;
+
+        /**
+         * Moves the built text out, the encoder is left empty.
+         */
+        std::string take();
+    };
+
 }
 
 #endif // MINICRAFTSERVER_UTILS_H
\ No newline at end of file
@@ -1,5 +1,17 @@
 #include "World.h"
+#include "JobSystem.h"
+#include "RegionFile.h"
+#include "ChunkIO.h"
+#include "WorldGenerator.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
 #include <unordered_map>
+#include <utility>
 
 using namespace mcplus;
 
@@ -13,29 +25,1269 @@ Tile::Tile() {
     this->data = 0;
 }
 
+bool Tile::operator==(const Tile& tile) const {
+    return id == tile.id && data == tile.data;
+}
+
+bool Tile::operator!=(const Tile& tile) const {
+    return !(*this == tile);
+}
+
+// the tiles of every chunk nothing was put in yet, so an unloaded slot costs no allocation
+static const std::shared_ptr<Chunk::Page>& emptyPage() {
+    static const std::shared_ptr<Chunk::Page> page = std::make_shared<Chunk::Page>(Chunk::Page{{Tile()}, {}, 0});
+    return page;
+}
+
+// a heap block of bytes as malloc hands it out, with its header and rounding
+static std::size_t allocated(std::size_t bytes) {
+    return bytes == 0 ? 0 : std::max<std::size_t>((bytes + sizeof(std::size_t) + 15) / 16 * 16, 32);
+}
+
 Chunk::Chunk() {
-    tiles.fill({0, 0});
+    // shared, so the first change makes the chunk its own page
+    this->page   = emptyPage();
+    this->shared = true;
+    this->dirty  = false;
+}
+
+Chunk::Chunk(const Tile& tile) {
+    this->page          = std::make_shared<Page>();
+    this->page->palette = {tile};
+    this->shared        = false;
+    this->dirty         = false;
+}
+
+Chunk::Chunk(const Chunk& chunk) {
+    this->page   = std::make_shared<Page>(*chunk.page);
+    this->shared = false;
+    this->dirty  = chunk.dirty;
+}
+
+Chunk& Chunk::operator=(const Chunk& chunk) {
+    if (this != &chunk) {
+        page   = std::make_shared<Page>(*chunk.page);
+        shared = false;
+        dirty  = chunk.dirty;
+    }
+
+    return *this;
+}
+
+Chunk::Chunk(Chunk&& chunk) noexcept {
+    this->page   = std::exchange(chunk.page, emptyPage());
+    this->shared = std::exchange(chunk.shared, true);
+    this->dirty  = std::exchange(chunk.dirty, false);
+}
+
+Chunk& Chunk::operator=(Chunk&& chunk) noexcept {
+    if (this != &chunk) {
+        page   = std::exchange(chunk.page, emptyPage());
+        shared = std::exchange(chunk.shared, true);
+        dirty  = std::exchange(chunk.dirty, false);
+    }
+
+    return *this;
+}
+
+Chunk::Page& Chunk::writablePage() {
+    if (shared && page.use_count() == 1) {
+        // the snapshots are done with it, what they read happened before they let go
+        std::atomic_thread_fence(std::memory_order_acquire);
+        shared = false;
+    }
+    if (shared) {
+        // a snapshot may be reading it on another thread right now
+        page   = std::make_shared<Page>(*page);
+        shared = false;
+    }
+
+    return *page;
+}
+
+std::size_t Chunk::Page::indexAt(std::size_t position) const {
+    std::size_t bit = position * bitsPerTile;
+    return (indices[bit >> 6] >> (bit & 63)) & ((1u << bitsPerTile) - 1);
+}
+
+void Chunk::Page::setIndexAt(std::size_t position, std::size_t index) {
+    std::size_t bit = position * bitsPerTile;
+    uint64_t mask = static_cast<uint64_t>((1u << bitsPerTile) - 1) << (bit & 63);
+
+    auto& word = indices[bit >> 6];
+    word = (word & ~mask) | (static_cast<uint64_t>(index) << (bit & 63));
+}
+
+void Chunk::Page::repack(uint8_t bits, const std::vector<std::size_t>& remap) {
+    if (bits == 0) {
+        bitsPerTile = 0;
+        indices.clear();
+        indices.shrink_to_fit();
+        return;
+    }
+
+    std::array<uint8_t, CHUNK_SIZE> unpacked{};
+    if (bitsPerTile != 0) {
+        for (std::size_t i = 0; i < CHUNK_SIZE; i++) {
+            unpacked[i] = static_cast<uint8_t>(remap[indexAt(i)]);
+        }
+    }
+
+    bitsPerTile = bits;
+
+    indices.assign(CHUNK_SIZE * bits / 64, 0);
+    indices.shrink_to_fit();
+    for (std::size_t i = 0; i < CHUNK_SIZE; i++) {
+        setIndexAt(i, unpacked[i]);
+    }
+}
+
+// smallest of 0, 1, 2, 4 and 8 bits able to address paletteSize entries
+static uint8_t bitsFor(std::size_t paletteSize) {
+    uint8_t bits = 0;
+    while ((std::size_t{1} << bits) < paletteSize) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+
+    return bits;
+}
+
+Tile Chunk::getTileAt(const Vector2i& pos) const {
+    if (page->bitsPerTile == 0) {
+        return page->palette[0];
+    }
+
+    return page->palette[page->indexAt(pos.x + (pos.y << CHUNK_SHIFT))];
+}
+
+void Chunk::setTileAt(const Vector2i& pos, const Tile& tile) {
+    std::size_t position = pos.x + (pos.y << CHUNK_SHIFT);
+    if (page->bitsPerTile == 0 && page->palette[0] == tile) {
+        return;
+    }
+    dirty = true;
+
+    Page& tiles = writablePage();
+    auto& palette = tiles.palette;
+    auto it = std::find(palette.begin(), palette.end(), tile);
+    std::size_t index = it - palette.begin();
+
+    if (it == palette.end()) {
+        if (palette.size() == (std::size_t{1} << tiles.bitsPerTile)) {
+            compact();
+        }
+        if (palette.size() == CHUNK_SIZE) {
+            // every tile differs, so the replaced one owns its palette entry
+            palette[tiles.indexAt(position)] = tile;
+            return;
+        }
+
+        index = palette.size();
+        palette.push_back(tile);
+
+        if (palette.size() > (std::size_t{1} << tiles.bitsPerTile)) {
+            std::vector<std::size_t> identity(palette.size());
+            for (std::size_t i = 0; i < identity.size(); i++) {
+                identity[i] = i;
+            }
+            tiles.repack(bitsFor(palette.size()), identity);
+        }
+    }
+
+    tiles.setIndexAt(position, index);
+}
+
+void Chunk::fill(const Tile& tile) {
+    dirty = true;
+    // nothing of the old tiles is kept, a snapshot can have them
+    page   = std::make_shared<Page>();
+    page->palette = {tile};
+    shared = false;
+}
+
+void Chunk::compact() {
+    if (page->bitsPerTile == 0) {
+        return;
+    }
+
+    const auto& palette = page->palette;
+    std::vector<bool> used(palette.size(), false);
+    for (std::size_t i = 0; i < CHUNK_SIZE; i++) {
+        used[page->indexAt(i)] = true;
+    }
+
+    std::vector<Tile> newPalette{};
+    std::vector<std::size_t> remap(palette.size(), 0);
+    for (std::size_t i = 0; i < palette.size(); i++) {
+        if (used[i]) {
+            remap[i] = newPalette.size();
+            newPalette.push_back(palette[i]);
+        }
+    }
+
+    if (newPalette.size() == palette.size()) {
+        return;
+    }
+
+    Page& tiles = writablePage();
+    tiles.repack(bitsFor(newPalette.size()), remap);
+    tiles.palette = std::move(newPalette);
+    tiles.palette.shrink_to_fit();
+}
+
+bool Chunk::isUniform() const {
+    return page->bitsPerTile == 0;
+}
+
+std::size_t Chunk::getPaletteSize() const {
+    return page->palette.size();
+}
+
+const std::vector<Tile>& Chunk::getPalette() const {
+    return page->palette;
+}
+
+std::size_t Chunk::memoryUsage() const {
+    if (page == emptyPage()) {
+        return sizeof(Chunk);
+    }
+
+    // make_shared puts the page next to its reference counts
+    return sizeof(Chunk) + allocated(sizeof(Page) + 2 * sizeof(int) + sizeof(void*))
+           + allocated(page->palette.capacity() * sizeof(Tile)) + allocated(page->indices.capacity() * sizeof(uint64_t));
+}
+
+void Chunk::Page::encode(std::string& out) const {
+    out.push_back(static_cast<char>(bitsPerTile));
+    out.push_back(static_cast<char>(palette.size() & 0xFF));
+    out.push_back(static_cast<char>(palette.size() >> 8));
+
+    for (const auto& tile : palette) {
+        out.push_back(static_cast<char>(tile.id & 0xFF));
+        out.push_back(static_cast<char>(tile.id >> 8));
+        out.push_back(static_cast<char>(tile.data));
+    }
+
+    for (uint64_t word : indices) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            out.push_back(static_cast<char>((word >> shift) & 0xFF));
+        }
+    }
+}
+
+void Chunk::encode(std::string& out) const {
+    page->encode(out);
+}
+
+bool Chunk::decode(std::string_view data) {
+    auto byteAt = [&data](std::size_t index) {
+        return static_cast<uint8_t>(data[index]);
+    };
+
+    if (data.size() < 3) {
+        return false;
+    }
+
+    uint8_t bits = byteAt(0);
+    std::size_t paletteSize = byteAt(1) | static_cast<std::size_t>(byteAt(2)) << 8;
+    std::size_t wordCount = CHUNK_SIZE * bits / 64;
+
+    if (bitsFor(paletteSize) > bits || bits > 8 || (bits & (bits - 1)) != 0 || paletteSize == 0
+        || data.size() != 3 + paletteSize * 3 + wordCount * 8) {
+        return false;
+    }
+
+    std::vector<Tile> newPalette(paletteSize);
+    for (std::size_t i = 0; i < paletteSize; i++) {
+        std::size_t at = 3 + i * 3;
+        newPalette[i] = Tile(static_cast<TileId>(byteAt(at) | byteAt(at + 1) << 8), byteAt(at + 2));
+    }
+
+    std::vector<uint64_t> newIndices(wordCount);
+    for (std::size_t i = 0; i < wordCount; i++) {
+        std::size_t at = 3 + paletteSize * 3 + i * 8;
+        for (int byte = 0; byte < 8; byte++) {
+            newIndices[i] |= static_cast<uint64_t>(byteAt(at + byte)) << (byte * 8);
+        }
+    }
+
+    // an index past the palette would read out of bounds later on
+    for (std::size_t i = 0; bits != 0 && i < CHUNK_SIZE; i++) {
+        std::size_t bit = i * bits;
+        if (((newIndices[bit >> 6] >> (bit & 63)) & ((1u << bits) - 1)) >= paletteSize) {
+            return false;
+        }
+    }
+
+    page = std::make_shared<Page>();
+    page->palette     = std::move(newPalette);
+    page->indices     = std::move(newIndices);
+    page->bitsPerTile = bits;
+    shared = false;
+    // the same as on disk
+    dirty  = false;
+
+    return true;
+}
+
+bool Chunk::isDirty() const {
+    return dirty;
+}
+
+void Chunk::setDirty(bool dirty) {
+    this->dirty = dirty;
+}
+
+std::shared_ptr<const Chunk::Page> Chunk::share() {
+    shared = true;
+    return page;
+}
+
+Chunk* Region::find(int index) {
+    return loaded[index] ? &chunks[index] : nullptr;
+}
+
+const Chunk* Region::find(int index) const {
+    return loaded[index] ? &chunks[index] : nullptr;
+}
+
+Chunk& Region::load(int index) {
+    // an unloaded slot is already an empty chunk, unload() left it so
+    loaded.set(index);
+    return chunks[index];
 }
 
-Tile& Chunk::getTileAt(const Vector2i& pos) {
-    return tiles[pos.x + (pos.y * 16)];
+bool Region::unload(int index) {
+    if (!loaded[index]) {
+        return false;
+    }
+
+    loaded.reset(index);
+    chunks[index] = Chunk();
+    return true;
 }
 
-const Tile& Chunk::getTileAt(const Vector2i& pos) const {
-    return tiles[pos.x + (pos.y * 16)];
+std::size_t Region::size() const {
+    return loaded.count();
 }
 
-World::World(const std::string& name) {
+std::size_t Region::memoryUsage() const {
+    // unloaded slots share the empty page, only their Chunk is counted
+    std::size_t usage = allocated(sizeof(Region));
+    for (int index = 0; index < REGION_SIZE; index++) {
+        if (loaded[index]) {
+            usage += chunks[index].memoryUsage() - sizeof(Chunk);
+        }
+    }
+
+    return usage;
+}
+
+ChunkStore::ChunkStore() {
+    this->origin     = {0, 0};
+    this->width      = 0;
+    this->height     = 0;
+    this->chunkCount = 0;
+}
+
+int ChunkStore::regionIndexOf(const Vector2i& regionPos) const {
+    int x = regionPos.x - origin.x;
+    int y = regionPos.y - origin.y;
+
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return -1;
+    }
+
+    return x + y * width;
+}
+
+void ChunkStore::grow(const Vector2i& regionPos) {
+    if (width == 0) {
+        regions.resize(1);
+        origin = regionPos;
+        width  = 1;
+        height = 1;
+        return;
+    }
+
+    Vector2i newOrigin{std::min(origin.x, regionPos.x), std::min(origin.y, regionPos.y)};
+    int newWidth  = std::max(origin.x + width, regionPos.x + 1) - newOrigin.x;
+    int newHeight = std::max(origin.y + height, regionPos.y + 1) - newOrigin.y;
+
+    std::vector<std::unique_ptr<Region>> newRegions(static_cast<std::size_t>(newWidth) * newHeight);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int newIndex = (origin.x - newOrigin.x + x) + (origin.y - newOrigin.y + y) * newWidth;
+            newRegions[newIndex] = std::move(regions[x + y * width]);
+        }
+    }
+
+    regions = std::move(newRegions);
+    origin  = newOrigin;
+    width   = newWidth;
+    height  = newHeight;
+}
+
+Chunk* ChunkStore::find(const Vector2i& chunkPos) {
+    int index = regionIndexOf(regionOf(chunkPos));
+    if (index < 0 || !regions[index]) {
+        return nullptr;
+    }
+
+    return regions[index]->find(Region::indexOf(chunkPos));
+}
+
+const Chunk* ChunkStore::find(const Vector2i& chunkPos) const {
+    int index = regionIndexOf(regionOf(chunkPos));
+    if (index < 0 || !regions[index]) {
+        return nullptr;
+    }
+
+    return regions[index]->find(Region::indexOf(chunkPos));
+}
+
+Chunk& ChunkStore::load(const Vector2i& chunkPos) {
+    Vector2i regionPos = regionOf(chunkPos);
+
+    int index = regionIndexOf(regionPos);
+    if (index < 0) {
+        grow(regionPos);
+        index = regionIndexOf(regionPos);
+    }
+
+    auto& region = regions[index];
+    if (!region) {
+        region = std::make_unique<Region>();
+    }
+
+    int chunkIndex = Region::indexOf(chunkPos);
+    if (region->find(chunkIndex) == nullptr) {
+        chunkCount++;
+    }
+
+    return region->load(chunkIndex);
+}
+
+bool ChunkStore::unload(const Vector2i& chunkPos) {
+    int index = regionIndexOf(regionOf(chunkPos));
+    if (index < 0 || !regions[index] || !regions[index]->unload(Region::indexOf(chunkPos))) {
+        return false;
+    }
+
+    chunkCount--;
+    // give the memory back once a whole region is gone
+    if (regions[index]->size() == 0) {
+        regions[index].reset();
+    }
+
+    return true;
+}
+
+bool ChunkStore::containsRegion(const Vector2i& regionPos) const {
+    int index = regionIndexOf(regionPos);
+    return index >= 0 && regions[index] != nullptr;
+}
+
+bool ChunkStore::contains(const Vector2i& chunkPos) const {
+    return find(chunkPos) != nullptr;
+}
+
+std::size_t ChunkStore::size() const {
+    return chunkCount;
+}
+
+std::size_t ChunkStore::memoryUsage() const {
+    std::size_t usage = sizeof(ChunkStore) + regions.capacity() * sizeof(std::unique_ptr<Region>);
+    for (const auto& region : regions) {
+        if (region) {
+            usage += region->memoryUsage();
+        }
+    }
+
+    return usage;
+}
+
+World::World(WorldId id, const std::string& name) {
+    this->worldId = id;
     this->name = name;
+    this->tickCount = 0;
+    this->storage = nullptr;
+    this->io = nullptr;
+    this->generator = nullptr;
+    this->pendingLoads.clear();
+    this->chunkReferences = {};
+    this->unreferencedChunks = {};
+    this->unreferencedAt = {};
+    this->memoryBudget = 0;
+    this->lastMemoryUsage = 0;
     loadedChunks = {};
+    entities = {};
+    entityIndex = {};
+    entityStorage.setSpatialIndex(&spatialIndex);
+}
+
+World::~World() = default;
+
+WorldId World::getId() const {
+    return worldId;
+}
+
+const std::string& World::getName() const {
+    return name;
+}
+
+void World::open(const std::string& directory, ChunkIO* io) {
+    this->storage = std::make_shared<RegionStorage>(directory);
+    this->io      = io;
+    // what was being read comes from the old directory
+    this->pendingLoads.clear();
+}
+
+bool World::isOpen() const {
+    return storage != nullptr;
+}
+
+void World::setGenerator(const WorldGenerator* generator) {
+    this->generator = generator;
+}
+
+const WorldGenerator* World::getGenerator() const {
+    return generator;
+}
+
+static uint64_t chunkKey(const Vector2i& pos) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32 | static_cast<uint32_t>(pos.y);
+}
+
+// from disk, else from the generator, else left empty
+static void fill(RegionStorage* storage, const WorldGenerator* generator, WorldId level, const Vector2i& pos, Chunk& chunk) {
+    if (storage != nullptr && storage->read(pos, chunk)) {
+        return;
+    }
+    if (generator != nullptr) {
+        generator->generate(level, pos, chunk);
+        chunk.setDirty(false);
+    }
+}
+
+bool World::requestChunk(const Vector2i& pos) {
+    if (loadedChunks.contains(pos)) {
+        return true;
+    }
+    if (storage == nullptr || io == nullptr) {
+        getChunkAt(pos);
+        return true;
+    }
+
+    auto [it, inserted] = pendingLoads.try_emplace(chunkKey(pos));
+    if (inserted) {
+        // the job holds the storage, not the world, it may outlive neither
+        auto task = std::make_shared<std::packaged_task<Chunk()>>([storage = storage, generator = generator, level = worldId, pos]() {
+            Chunk chunk{};
+            fill(storage.get(), generator, level, pos, chunk);
+            return chunk;
+        });
+        it->second = ChunkLoad{pos, task->get_future()};
+        io->submitRead([task]() {
+            (*task)();
+        });
+    }
+
+    return false;
+}
+
+bool World::isLoading(const Vector2i& pos) const {
+    return pendingLoads.find(chunkKey(pos)) != pendingLoads.end();
+}
+
+std::size_t World::getLoadingCount() const {
+    return pendingLoads.size();
+}
+
+void World::track(const Vector2i& pos) {
+    uint64_t key = chunkKey(pos);
+    if (chunkReferences.find(key) == chunkReferences.end()) {
+        unreferencedAt[key] = unreferencedChunks.insert(unreferencedChunks.end(), pos);
+    }
+}
+
+Chunk& World::install(ChunkLoad& load) {
+    Chunk& chunk = loadedChunks.load(load.position);
+    track(load.position);
+    chunk = load.chunk.get();
+    return chunk;
+}
+
+std::size_t World::installLoads() {
+    std::size_t installed = 0;
+    std::exception_ptr failure{};
+
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end();) {
+        if (it->second.chunk.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        try {
+            install(it->second);
+        } catch (const std::runtime_error& exception) {
+            failure = failure ? failure : std::current_exception();
+        }
+        it = pendingLoads.erase(it);
+        installed++;
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    return installed;
+}
+
+namespace {
+
+    // a dirty chunk as it was when written back, its index in the region and its tiles
+    struct ChunkPage {
+        int index;
+        std::shared_ptr<const Chunk::Page> page;
+    };
+
+    // an item on the ground as it was when written back, first and second
+    // hold the amount of a stack or the level and durability of a tool
+    struct ItemImage {
+        Location2f location;
+        int32_t lifeTime;
+        ItemId id;
+        uint32_t first;
+        uint32_t second;
+    };
+
+    constexpr uint32_t ITEM_MAGIC = 0x5449434D; // "MCIT" read little-endian
+
+}
+
+// the tick only hands over the pages, encoding them is left to the writer
+static void writeChunks(const std::shared_ptr<RegionStorage>& storage, ChunkIO* io, const Vector2i& regionPos,
+                        std::vector<ChunkPage> pages) {
+    storage->beginWrite(regionPos);
+    auto write = [storage, regionPos, pages = std::move(pages)]() {
+        std::vector<RegionFile::ChunkData> chunks{};
+        chunks.reserve(pages.size());
+        for (const auto& [index, page] : pages) {
+            RegionFile::ChunkData data{index, {}};
+            page->encode(data.data);
+            chunks.push_back(std::move(data));
+        }
+        storage->write(regionPos, std::move(chunks));
+    };
+
+    if (io == nullptr) {
+        write();
+        return;
+    }
+    io->submitWrite(std::move(write));
+}
+
+static void appendUint32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static uint32_t uint32At(std::string_view data, std::size_t at) {
+    uint32_t value = 0;
+    for (int byte = 0; byte < 4; byte++) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data[at + byte])) << (byte * 8);
+    }
+    return value;
+}
+
+// copying an Item would slice its data, so the fields are read out here
+static ItemImage imageOf(const Location2f& location, int32_t lifeTime, const Item& item) {
+    ItemImage image{location, lifeTime, item.id(), 0, 0};
+    if (const auto* stack = dynamic_cast<const ItemStackableData*>(&item.data())) {
+        image.first = stack->amount;
+    } else if (const auto* tool = dynamic_cast<const ItemToolData*>(&item.data())) {
+        image.first  = static_cast<uint32_t>(tool->level);
+        image.second = static_cast<uint32_t>(tool->durability);
+    }
+    return image;
+}
+
+static std::shared_ptr<Item> itemOf(const ItemImage& image) {
+    auto item = std::make_shared<Item>(image.id);
+    if (auto* stack = dynamic_cast<ItemStackableData*>(&item->data())) {
+        stack->amount = static_cast<uint16_t>(image.first);
+    } else if (auto* tool = dynamic_cast<ItemToolData*>(&item->data())) {
+        tool->level      = static_cast<ItemToolData::Level>(image.first);
+        tool->durability = static_cast<int32_t>(image.second);
+    }
+    return item;
+}
+
+/*
+ * Little-endian like the chunks: magic and item count, then the position,
+ * life time, id and data fields of every item, then a CRC-32 of it all.
+ */
+static std::string encodeItems(const std::vector<ItemImage>& items) {
+    std::string out{};
+    appendUint32(out, ITEM_MAGIC);
+    appendUint32(out, static_cast<uint32_t>(items.size()));
+
+    for (const auto& image : items) {
+        appendUint32(out, std::bit_cast<uint32_t>(image.location.x));
+        appendUint32(out, std::bit_cast<uint32_t>(image.location.y));
+        appendUint32(out, static_cast<uint32_t>(image.lifeTime));
+        appendUint32(out, image.id);
+        appendUint32(out, image.first);
+        appendUint32(out, image.second);
+    }
+
+    appendUint32(out, utils::crc32(out));
+    return out;
+}
+
+// false when data is damaged
+static bool decodeItems(std::string_view data, WorldId level, std::vector<ItemImage>& items) {
+    constexpr std::size_t RECORD_SIZE = 24;
+    if (data.size() < 12 || uint32At(data, 0) != ITEM_MAGIC
+        || uint32At(data, data.size() - 4) != utils::crc32(data.substr(0, data.size() - 4))
+        || data.size() - 12 != static_cast<std::size_t>(uint32At(data, 4)) * RECORD_SIZE) {
+        return false;
+    }
+
+    for (std::size_t at = 8; at < data.size() - 4; at += RECORD_SIZE) {
+        Location2f location{level, std::bit_cast<float>(uint32At(data, at)), std::bit_cast<float>(uint32At(data, at + 4))};
+        items.push_back({location, static_cast<int32_t>(uint32At(data, at + 8)), static_cast<ItemId>(uint32At(data, at + 12)),
+                         uint32At(data, at + 16), uint32At(data, at + 20)});
+    }
+    return true;
+}
+
+std::size_t World::writeBack() {
+    if (!isOpen()) {
+        throw std::logic_error("World::writeBack(): " + name + " has no directory to write to");
+    }
+
+    std::size_t written = 0;
+    loadedChunks.forEachRegion([this, &written](const Vector2i& regionPos, Region& region) {
+        std::vector<ChunkPage> pages{};
+        region.forEachChunk(regionPos, [&pages](const Vector2i& position, Chunk& chunk) {
+            if (chunk.isDirty()) {
+                pages.push_back({Region::indexOf(position), chunk.share()});
+                chunk.setDirty(false);
+            }
+        });
+        if (pages.empty()) {
+            return;
+        }
+
+        written += pages.size();
+        writeChunks(storage, io, regionPos, std::move(pages));
+    });
+
+    // arrows are gone within seconds and their owners with the players, only items are kept
+    const auto& items = entityStorage.getItems();
+    std::vector<ItemImage> images{};
+    images.reserve(items.size());
+    for (std::size_t row = 0; row < items.size(); row++) {
+        // an item entity may hold no item, there is nothing of it to keep
+        if ((items.flags[row] & EntityStorage::REMOVED) == 0 && items.items[row] != nullptr) {
+            images.push_back(imageOf(items.locations[row], items.lifeTimes[row], *items.items[row]));
+        }
+    }
+    auto writeItems = [storage = storage, images = std::move(images)]() {
+        storage->writeEntities(encodeItems(images));
+    };
+    if (io == nullptr) {
+        writeItems();
+    } else {
+        io->submitWrite(std::move(writeItems));
+    }
+
+    return written;
+}
+
+std::size_t World::loadEntities() {
+    if (!isOpen()) {
+        throw std::logic_error("World::loadEntities(): " + name + " has no directory to read from");
+    }
+
+    std::string data{};
+    if (!storage->readEntities(data)) {
+        return 0;
+    }
+
+    std::vector<ItemImage> items{};
+    if (!decodeItems(data, worldId, items)) {
+        throw std::runtime_error("Damaged " + std::string(RegionStorage::ENTITY_FILE) + " in " + storage->getDirectory()
+                                 + ", its entities are lost");
+    }
+    for (const auto& image : items) {
+        addEntity(std::make_shared<ItemEntity>(image.location, itemOf(image), image.lifeTime));
+    }
+
+    return items.size();
+}
+
+std::size_t World::save() {
+    std::size_t written = writeBack();
+    if (io != nullptr) {
+        io->wait();
+    }
+
+    return written;
 }
 
 Chunk& World::getChunkAt(const Vector2i& pos) {
-    return loadedChunks[pos];
+    if (Chunk* chunk = loadedChunks.find(pos)) {
+        return *chunk;
+    }
+
+    auto pending = pendingLoads.find(chunkKey(pos));
+    if (pending != pendingLoads.end()) {
+        ChunkLoad load = std::move(pending->second);
+        pendingLoads.erase(pending);
+        return install(load);
+    }
+
+    Chunk& chunk = loadedChunks.load(pos);
+    track(pos);
+    fill(storage.get(), generator, worldId, pos, chunk);
+
+    return chunk;
+}
+
+std::size_t World::pregenerate(const Vector2i& from, const Vector2i& to, JobSystem* jobs) {
+    // the slots are made here, the jobs only fill chunks that don't move
+    std::vector<ChunkRef> missing{};
+    for (int x = from.x; x < to.x; x++) {
+        for (int y = from.y; y < to.y; y++) {
+            if (!loadedChunks.contains({x, y}) && !isLoading({x, y})) {
+                missing.push_back({{x, y}, &loadedChunks.load({x, y})});
+                track({x, y});
+            }
+        }
+    }
+
+    std::atomic<std::size_t> damaged{0};
+    auto body = [this, &missing, &damaged](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            try {
+                fill(storage.get(), generator, worldId, missing[i].position, *missing[i].chunk);
+            } catch (const std::runtime_error& exception) {
+                damaged++;
+            }
+        }
+    };
+    if (jobs != nullptr) {
+        jobs->parallelFor(missing.size(), GENERATE_GRAIN, body);
+    } else {
+        body(0, missing.size());
+    }
+
+    if (damaged > 0) {
+        throw std::runtime_error(std::to_string(damaged) + " damaged chunks in " + name + ", left empty");
+    }
+    return missing.size();
+}
+
+void World::retainChunks(const Vector2i& center, int radius) {
+    for (int x = center.x - radius; x <= center.x + radius; x++) {
+        for (int y = center.y - radius; y <= center.y + radius; y++) {
+            uint64_t key = chunkKey({x, y});
+            if (chunkReferences[key]++ > 0) {
+                continue;
+            }
+
+            auto unreferenced = unreferencedAt.find(key);
+            if (unreferenced != unreferencedAt.end()) {
+                unreferencedChunks.erase(unreferenced->second);
+                unreferencedAt.erase(unreferenced);
+            }
+        }
+    }
+}
+
+void World::releaseChunks(const Vector2i& center, int radius) {
+    for (int x = center.x - radius; x <= center.x + radius; x++) {
+        for (int y = center.y - radius; y <= center.y + radius; y++) {
+            auto references = chunkReferences.find(chunkKey({x, y}));
+            if (references == chunkReferences.end() || --references->second > 0) {
+                continue;
+            }
+
+            chunkReferences.erase(references);
+            if (loadedChunks.contains({x, y})) {
+                track({x, y});
+            }
+        }
+    }
+}
+
+void World::setMemoryBudget(std::size_t bytes) {
+    this->memoryBudget = bytes;
+}
+
+std::size_t World::getMemoryBudget() const {
+    return memoryBudget;
+}
+
+// the list node, the map node and the bucket that remember an unreferenced chunk
+static std::size_t trackingSize() {
+    return allocated(sizeof(Vector2i) + 2 * sizeof(void*)) + allocated(sizeof(uint64_t) + 2 * sizeof(void*)) + sizeof(void*);
+}
+
+std::size_t World::evictChunks() {
+    std::size_t usage = memoryUsage();
+    lastMemoryUsage = usage;
+    if (memoryBudget == 0 || usage <= memoryBudget) {
+        return 0;
+    }
+
+    // written back by region like writeBack(), keyed like the chunks
+    std::unordered_map<uint64_t, std::vector<ChunkPage>> writes{};
+    std::size_t evicted = 0;
+    for (auto it = unreferencedChunks.begin(); it != unreferencedChunks.end() && usage > memoryBudget;) {
+        Vector2i pos = *it;
+        Chunk& chunk = *loadedChunks.find(pos);
+        if (chunk.isDirty()) {
+            if (storage == nullptr) {
+                // the only copy there is
+                ++it;
+                continue;
+            }
+
+            writes[chunkKey(ChunkStore::regionOf(pos))].push_back({Region::indexOf(pos), chunk.share()});
+        }
+
+        usage -= chunk.memoryUsage() - sizeof(Chunk) + trackingSize();
+        loadedChunks.unload(pos);
+        if (!loadedChunks.containsRegion(ChunkStore::regionOf(pos))) {
+            usage -= allocated(sizeof(Region));
+        }
+
+        unreferencedAt.erase(chunkKey(pos));
+        it = unreferencedChunks.erase(it);
+        evicted++;
+    }
+
+    for (auto& [key, chunks] : writes) {
+        Vector2i regionPos{static_cast<int>(static_cast<uint32_t>(key >> 32)), static_cast<int>(static_cast<uint32_t>(key))};
+        std::sort(chunks.begin(), chunks.end(), [](const ChunkPage& a, const ChunkPage& b) {
+            return a.index < b.index;
+        });
+        writeChunks(storage, io, regionPos, std::move(chunks));
+    }
+
+    lastMemoryUsage = usage;
+    return evicted;
+}
+
+std::size_t World::getLastMemoryUsage() const {
+    return lastMemoryUsage;
 }
 
 const Chunk& World::getChunkAt(const Vector2i& pos) const {
-    return loadedChunks.at(pos);
+    const Chunk* chunk = loadedChunks.find(pos);
+    if (chunk == nullptr) {
+        throw std::out_of_range("Chunk isn't loaded");
+    }
+
+    return *chunk;
+}
+
+Tile World::getTileAt(const Vector2i& pos) const {
+    return getChunkAt({pos.x >> Chunk::CHUNK_SHIFT, pos.y >> Chunk::CHUNK_SHIFT})
+            .getTileAt({pos.x & static_cast<int>(Chunk::CHUNK_WIDTH - 1), pos.y & static_cast<int>(Chunk::CHUNK_HEIGHT - 1)});
+}
+
+void World::setTileAt(const Vector2i& pos, const Tile& tile) {
+    getChunkAt({pos.x >> Chunk::CHUNK_SHIFT, pos.y >> Chunk::CHUNK_SHIFT})
+            .setTileAt({pos.x & static_cast<int>(Chunk::CHUNK_WIDTH - 1), pos.y & static_cast<int>(Chunk::CHUNK_HEIGHT - 1)}, tile);
+}
+
+std::size_t World::memoryUsage() const {
+    return loadedChunks.memoryUsage() + unreferencedAt.size() * trackingSize();
+}
+
+void World::tick(JobSystem* jobs) {
+    tickTiles(jobs);
+
+    entityStorage.tickArrows(jobs);
+    entityStorage.tickItems(jobs);
+
+    removedEntities.clear();
+    entityStorage.sweep(removedEntities);
+    for (EntityId removed : removedEntities) {
+        eraseEntity(removed);
+        // the entity is gone for good, old copies of its id turn stale
+        EntityIdAllocator::global().release(removed);
+    }
+
+    levelChanges.clear();
+    entityStorage.takeLevelChanges(levelChanges);
+    for (EntityId changed : levelChanges) {
+        if (entityStorage.contains(changed) && entityStorage.getLocation(changed).world != worldId
+            && std::find(departures.begin(), departures.end(), changed) == departures.end()) {
+            departures.push_back(changed);
+        }
+    }
+
+    if (tickCount % EVICTION_TICKS == 0) {
+        evictChunks();
+    }
+    // last, a damaged chunk throwing doesn't cut the tick short
+    installLoads();
+}
+
+std::optional<Tile> World::findTileAt(const Vector2i& pos) const {
+    const Chunk* chunk = loadedChunks.find({pos.x >> Chunk::CHUNK_SHIFT, pos.y >> Chunk::CHUNK_SHIFT});
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+
+    return chunk->getTileAt({pos.x & static_cast<int>(Chunk::CHUNK_WIDTH - 1), pos.y & static_cast<int>(Chunk::CHUNK_HEIGHT - 1)});
+}
+
+void World::tickTiles(JobSystem* jobs) {
+    for (auto& colour : chunkColours) {
+        colour.clear();
+    }
+    loadedChunks.forEachChunk([this](const Vector2i& position, Chunk& chunk) {
+        chunkColours[(position.x & 1) | (position.y & 1) << 1].push_back({position, &chunk});
+    });
+
+    for (const auto& colour : chunkColours) {
+        if (haloWrites.size() < colour.size()) {
+            haloWrites.resize(colour.size());
+        }
+
+        auto body = [this, &colour](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                tickChunk(colour[i], haloWrites[i]);
+            }
+        };
+        if (jobs != nullptr) {
+            jobs->parallelFor(colour.size(), TILE_TICK_GRAIN, body);
+        } else {
+            body(0, colour.size());
+        }
+
+        // in chunk order, whatever thread produced them
+        for (std::size_t i = 0; i < colour.size(); i++) {
+            for (const auto& write : haloWrites[i]) {
+                Chunk* chunk = loadedChunks.find({write.position.x >> Chunk::CHUNK_SHIFT, write.position.y >> Chunk::CHUNK_SHIFT});
+                if (chunk != nullptr) {
+                    chunk->setTileAt({write.position.x & static_cast<int>(Chunk::CHUNK_WIDTH - 1),
+                                      write.position.y & static_cast<int>(Chunk::CHUNK_HEIGHT - 1)}, write.tile);
+                }
+            }
+            haloWrites[i].clear();
+        }
+    }
+
+    tickCount++;
+}
+
+namespace {
+
+    // splitmix64, every chunk draws from its own stream seeded by where and when it ticks
+    class TickRandom {
+        uint64_t state;
+    public:
+        explicit TickRandom(uint64_t seed) {
+            this->state = seed;
+        }
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        int nextInt(int bound) {
+            return static_cast<int>(next() % static_cast<uint64_t>(bound));
+        }
+    };
+
+    // ticks before a sapling grows up, and ripeness of a crop, kept in the tile data
+    constexpr uint8_t SAPLING_AGE = 100;
+    constexpr uint8_t CROP_AGE    = 50;
+
+    bool hasRandomTick(const Tile& tile) {
+        switch (static_cast<TileMaterial>(tile.id)) {
+            case TileMaterial::GRASS:
+            case TileMaterial::TREE_SAPLING:
+            case TileMaterial::CACTUS_SAPLING:
+            case TileMaterial::WHEAT:
+            case TileMaterial::POTATO:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+}
+
+void World::tickChunk(const ChunkRef& chunk, std::vector<TileWrite>& halo) {
+    const auto& palette = chunk.chunk->getPalette();
+    if (std::none_of(palette.begin(), palette.end(), hasRandomTick)) {
+        return;
+    }
+
+    uint64_t seed = static_cast<uint64_t>(static_cast<uint16_t>(worldId)) << 48 ^ tickCount << 24
+                    ^ static_cast<uint64_t>(static_cast<uint32_t>(chunk.position.x)) << 32 ^ static_cast<uint32_t>(chunk.position.y);
+    TickRandom random{seed};
+
+    auto write = [&chunk, &halo](const Vector2i& pos, const Tile& tile) {
+        if (pos.x >> Chunk::CHUNK_SHIFT == chunk.position.x && pos.y >> Chunk::CHUNK_SHIFT == chunk.position.y) {
+            chunk.chunk->setTileAt({pos.x & static_cast<int>(Chunk::CHUNK_WIDTH - 1), pos.y & static_cast<int>(Chunk::CHUNK_HEIGHT - 1)}, tile);
+        } else {
+            halo.push_back({pos, tile});
+        }
+    };
+
+    for (int i = 0; i < RANDOM_TICKS; i++) {
+        Vector2i local{random.nextInt(Chunk::CHUNK_WIDTH), random.nextInt(Chunk::CHUNK_HEIGHT)};
+        Vector2i pos{(chunk.position.x << Chunk::CHUNK_SHIFT) + local.x, (chunk.position.y << Chunk::CHUNK_SHIFT) + local.y};
+        Tile tile = chunk.chunk->getTileAt(local);
+
+        switch (static_cast<TileMaterial>(tile.id)) {
+            case TileMaterial::GRASS: {
+                if (random.nextInt(40) != 0) {
+                    break;
+                }
+
+                // spreads onto the dirt next to it, possibly over the chunk border
+                Vector2i neighbour = pos;
+                if (random.nextInt(2) == 0) {
+                    neighbour.x += random.nextInt(2) * 2 - 1;
+                } else {
+                    neighbour.y += random.nextInt(2) * 2 - 1;
+                }
+
+                auto target = findTileAt(neighbour);
+                if (target.has_value() && target->id == static_cast<TileId>(TileMaterial::DIRT)) {
+                    write(neighbour, Tile{static_cast<TileId>(TileMaterial::GRASS), 0});
+                }
+                break;
+            }
+            case TileMaterial::TREE_SAPLING:
+            case TileMaterial::CACTUS_SAPLING: {
+                if (tile.data + 1 < SAPLING_AGE) {
+                    write(pos, Tile{tile.id, static_cast<uint8_t>(tile.data + 1)});
+                } else {
+                    bool tree = static_cast<TileMaterial>(tile.id) == TileMaterial::TREE_SAPLING;
+                    write(pos, Tile{static_cast<TileId>(tree ? TileMaterial::TREE : TileMaterial::CACTUS), 0});
+                }
+                break;
+            }
+            case TileMaterial::WHEAT:
+            case TileMaterial::POTATO: {
+                if (tile.data < CROP_AGE && random.nextInt(2) == 0) {
+                    write(pos, Tile{tile.id, static_cast<uint8_t>(tile.data + 1)});
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void World::takeDepartures(std::vector<EntityId>& departed) {
+    departed.insert(departed.end(), departures.begin(), departures.end());
+    departures.clear();
+}
+
+const std::shared_ptr<Entity>* World::findEntity(EntityId id) const {
+    uint32_t index = EntityIdAllocator::indexOf(id);
+    if (index >= entityIndex.size() || entityIndex[index] == 0) {
+        return nullptr;
+    }
+
+    const auto& entity = entities[entityIndex[index] - 1];
+    return entity->id() == id ? &entity : nullptr;
+}
+
+void World::eraseEntity(EntityId id) {
+    uint32_t& position = entityIndex[EntityIdAllocator::indexOf(id)];
+
+    if (position != entities.size()) {
+        entities[position - 1] = std::move(entities.back());
+        entityIndex[EntityIdAllocator::indexOf(entities[position - 1]->id())] = position;
+    }
+    entities.pop_back();
+    position = 0;
+}
+
+void World::addEntity(const std::shared_ptr<Entity>& entity) {
+    if (findEntity(entity->id()) != nullptr) {
+        return;
+    }
+
+    uint32_t index = EntityIdAllocator::indexOf(entity->id());
+    if (index >= entityIndex.size()) {
+        entityIndex.resize(index + 1, 0);
+    }
+    entities.push_back(entity);
+    entityIndex[index] = static_cast<uint32_t>(entities.size());
+
+    entity->moveTo(entityStorage);
+}
+
+bool World::removeEntity(EntityId id) {
+    const std::shared_ptr<Entity>* entity = findEntity(id);
+    if (entity == nullptr) {
+        return false;
+    }
+
+    // whoever still holds the handle owns the entity from now on
+    if (entityStorage.contains(id)) {
+        (*entity)->moveTo(EntityStorage::detached());
+    }
+    eraseEntity(id);
+
+    return true;
+}
+
+std::shared_ptr<Entity> World::getEntity(EntityId id) const {
+    const std::shared_ptr<Entity>* entity = findEntity(id);
+    return entity != nullptr ? *entity : nullptr;
+}
+
+std::vector<std::shared_ptr<Entity>> World::getEntitiesIn(const Rectangle2f& area) const {
+    std::vector<std::shared_ptr<Entity>> found{};
+    spatialIndex.forEachIn(area, [this, &found](const SpatialHash::Entry& entry) {
+        const std::shared_ptr<Entity>* entity = findEntity(entry.id);
+        if (entity != nullptr) {
+            found.push_back(*entity);
+        }
+    });
+
+    return found;
+}
+
+std::vector<std::shared_ptr<Entity>> World::getEntitiesIn(const Circle2f& area) const {
+    std::vector<std::shared_ptr<Entity>> found{};
+    spatialIndex.forEachIn(area, [this, &found](const SpatialHash::Entry& entry) {
+        const std::shared_ptr<Entity>* entity = findEntity(entry.id);
+        if (entity != nullptr) {
+            found.push_back(*entity);
+        }
+    });
+
+    return found;
+}
+
+const SpatialHash& World::getSpatialIndex() const {
+    return spatialIndex;
+}
+
+EntityStorage& World::getEntityStorage() {
+    return entityStorage;
 }
 
 std::string mcplus::getTileName(TileMaterial tileMaterial) {
@@ -3,12 +3,20 @@
 
 #include <cstdint>
 #include <array>
+#include <bitset>
+#include <future>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "MinicraftDef.h"
 #include "Dimension.h"
 #include "Entity.h"
+#include "SpatialIndex.h"
 
 namespace mcplus {
 
@@ -65,35 +73,437 @@ namespace mcplus {
 
         Tile(TileId id, uint8_t data);
         Tile();
+
+        bool operator==(const Tile& tile) const;
+        bool operator!=(const Tile& tile) const;
     };
 
+    /**
+     * 16x16 tiles kept as a palette of the distinct tiles plus one packed
+     * palette index per tile. A chunk made of a single tile (all grass, all
+     * rock...) stores no indices at all.
+     */
     class Chunk {
-        static constexpr std::size_t CHUNK_WIDTH  = 16;
-        static constexpr std::size_t CHUNK_HEIGHT = 16;
-        static constexpr std::size_t CHUNK_SIZE   = CHUNK_WIDTH * CHUNK_HEIGHT; 
+    public:
+        static constexpr std::size_t CHUNK_SHIFT  = 4;
+        static constexpr std::size_t CHUNK_WIDTH  = 1 << CHUNK_SHIFT;
+        static constexpr std::size_t CHUNK_HEIGHT = 1 << CHUNK_SHIFT;
+        static constexpr std::size_t CHUNK_SIZE   = CHUNK_WIDTH * CHUNK_HEIGHT;
+
+        /**
+         * The tiles of a chunk. Snapshots share it with the chunk, which
+         * copies it before its next change instead of changing it in place.
+         */
+        struct Page {
+            std::vector<Tile> palette;
+            std::vector<uint64_t> indices;
+            // 0, 1, 2, 4 or 8: powers of two, so an index never straddles two words
+            uint8_t bitsPerTile = 0;
+
+            [[nodiscard]] std::size_t indexAt(std::size_t position) const;
+            void setIndexAt(std::size_t position, std::size_t index);
+            void repack(uint8_t bits, const std::vector<std::size_t>& remap);
 
-        std::array<Tile, Chunk::CHUNK_SIZE> tiles;
+            /**
+             * See Chunk::encode().
+             */
+            void encode(std::string& out) const;
+        };
+    private:
+        std::shared_ptr<Page> page;
+        // page was handed to a snapshot, the next change copies it first
+        bool shared;
+        // changed since it was last read or written back
+        bool dirty;
+
+        Page& writablePage();
     public:
         Chunk();
+        explicit Chunk(const Tile& tile);
+        // copies the tiles, a copy never shares them
+        Chunk(const Chunk& chunk);
+        // takes the tiles, leaving an empty chunk behind
+        Chunk(Chunk&& chunk) noexcept;
+        Chunk& operator=(const Chunk& chunk);
+        Chunk& operator=(Chunk&& chunk) noexcept;
+
+        [[nodiscard]] Tile getTileAt(const Vector2i& pos) const;
+        void setTileAt(const Vector2i& pos, const Tile& tile);
+
+        /**
+         * Makes every tile the given one, dropping back to the uniform form.
+         */
+        void fill(const Tile& tile);
+
+        /**
+         * Drops palette entries no tile uses anymore and shrinks the indices
+         * to match. Also done on its own before the palette grows.
+         */
+        void compact();
 
-        Tile& getTileAt(const Vector2i& pos);
-        [[nodiscard]] const Tile& getTileAt(const Vector2i& pos) const;
+        [[nodiscard]] bool isUniform() const;
+        [[nodiscard]] std::size_t getPaletteSize() const;
+        /**
+         * Every tile the chunk may hold, plus the unused ones until compact().
+         */
+        [[nodiscard]] const std::vector<Tile>& getPalette() const;
+        [[nodiscard]] std::size_t memoryUsage() const;
+
+        /**
+         * Appends the chunk as stored on disk, little-endian: bits per tile,
+         * palette size, the palette (id and data of each tile), then the
+         * packed indices as they are in memory.
+         */
+        void encode(std::string& out) const;
+        /**
+         * Replaces the chunk with an encoded one. False, leaving the chunk
+         * untouched, when data is not a valid chunk.
+         */
+        bool decode(std::string_view data);
+
+        [[nodiscard]] bool isDirty() const;
+        void setDirty(bool dirty);
+
+        /**
+         * The tiles as they are now, for a snapshot to read on any thread.
+         * Costs a pointer: the chunk leaves them alone from now on.
+         */
+        std::shared_ptr<const Page> share();
     };
 
-    class WorldGenerator {
+    /**
+     * A square block of REGION_WIDTH x REGION_WIDTH chunks laid out row by
+     * row in one allocation, so neighbouring chunks are neighbours in memory.
+     */
+    class Region {
+    public:
+        static constexpr int REGION_SHIFT = 5;
+        static constexpr int REGION_WIDTH = 1 << REGION_SHIFT;
+        static constexpr int REGION_SIZE  = REGION_WIDTH * REGION_WIDTH;
+    private:
+        std::array<Chunk, REGION_SIZE> chunks;
+        std::bitset<REGION_SIZE> loaded;
+    public:
+        Region() = default;
+
+        static int indexOf(const Vector2i& chunkPos) {
+            return (chunkPos.x & (REGION_WIDTH - 1)) + ((chunkPos.y & (REGION_WIDTH - 1)) << REGION_SHIFT);
+        }
+
+        Chunk* find(int index);
+        [[nodiscard]] const Chunk* find(int index) const;
 
+        Chunk& load(int index);
+        bool unload(int index);
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::size_t memoryUsage() const;
+
+        template<typename F>
+        void forEachChunk(const Vector2i& regionPos, F&& function) {
+            for (int index = 0; index < REGION_SIZE; index++) {
+                if (loaded[index]) {
+                    function(Vector2i((regionPos.x << REGION_SHIFT) + (index & (REGION_WIDTH - 1)),
+                                      (regionPos.y << REGION_SHIFT) + (index >> REGION_SHIFT)), chunks[index]);
+                }
+            }
+        }
+    };
+
+    /**
+     * Loaded chunks of a world, stored in a grid of regions that grows to
+     * cover whatever gets loaded. Finding a chunk is pure index math: no
+     * hashing and a single pointer to follow.
+     */
+    class ChunkStore {
+        std::vector<std::unique_ptr<Region>> regions;
+        Vector2i origin;
+        int width;
+        int height;
+        std::size_t chunkCount;
+
+        [[nodiscard]] int regionIndexOf(const Vector2i& regionPos) const;
+        void grow(const Vector2i& regionPos);
+    public:
+        ChunkStore();
+
+        static Vector2i regionOf(const Vector2i& chunkPos) {
+            return {chunkPos.x >> Region::REGION_SHIFT, chunkPos.y >> Region::REGION_SHIFT};
+        }
+
+        /**
+         * The chunk at chunkPos, or nullptr when it isn't loaded.
+         */
+        Chunk* find(const Vector2i& chunkPos);
+        [[nodiscard]] const Chunk* find(const Vector2i& chunkPos) const;
+
+        /**
+         * The chunk at chunkPos, loading an empty one when missing.
+         */
+        Chunk& load(const Vector2i& chunkPos);
+        bool unload(const Vector2i& chunkPos);
+
+        [[nodiscard]] bool contains(const Vector2i& chunkPos) const;
+        [[nodiscard]] bool containsRegion(const Vector2i& regionPos) const;
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::size_t memoryUsage() const;
+
+        /**
+         * Visits the regions holding any loaded chunk, with their region coordinates.
+         */
+        template<typename F>
+        void forEachRegion(F&& function) {
+            for (int index = 0; index < static_cast<int>(regions.size()); index++) {
+                if (regions[index]) {
+                    function(Vector2i(origin.x + index % width, origin.y + index / width), *regions[index]);
+                }
+            }
+        }
+
+        /**
+         * Visits loaded chunks in memory order, region by region.
+         */
+        template<typename F>
+        void forEachChunk(F&& function) {
+            for (int index = 0; index < static_cast<int>(regions.size()); index++) {
+                if (regions[index]) {
+                    regions[index]->forEachChunk(Vector2i(origin.x + index % width, origin.y + index / width), function);
+                }
+            }
+        }
     };
 
+    class JobSystem;
+    class ChunkIO;
+    class RegionStorage;
+    class WorldGenerator;
+
     class World {
+    public:
+        // random tile ticks per chunk per tick, about one tile in fifty like Minicraft+
+        static constexpr int RANDOM_TICKS = 5;
+        // chunks per job when the tile ticks run on a JobSystem
+        static constexpr std::size_t TILE_TICK_GRAIN = 16;
+        // ticks between two checks of the memory budget
+        static constexpr uint64_t EVICTION_TICKS = 60;
+        // chunks per job when pregenerating on a JobSystem
+        static constexpr std::size_t GENERATE_GRAIN = 32;
+    private:
+        struct ChunkRef {
+            Vector2i position;
+            Chunk* chunk;
+        };
+
+        struct TileWrite {
+            Vector2i position;
+            Tile tile;
+        };
+
+        struct ChunkLoad {
+            Vector2i position;
+            std::future<Chunk> chunk;
+        };
+
+        WorldId worldId;
         std::string name;
-        std::unordered_map<Vector2i, Chunk> loadedChunks;
+        ChunkStore loadedChunks;
+        uint64_t tickCount;
+
+        // null while the world only lives in memory
+        std::shared_ptr<RegionStorage> storage;
+        // null to read and write on the tick thread
+        ChunkIO* io;
+        // null to leave chunks missing from disk empty
+        const WorldGenerator* generator;
+        // requested, but not in loadedChunks yet
+        std::unordered_map<uint64_t, ChunkLoad> pendingLoads;
+
+        // view windows holding each chunk, loaded or not
+        std::unordered_map<uint64_t, uint32_t> chunkReferences;
+        // loaded chunks no view holds, the least recently loaded or released first
+        std::list<Vector2i> unreferencedChunks;
+        std::unordered_map<uint64_t, std::list<Vector2i>::iterator> unreferencedAt;
+        // 0 for no limit
+        std::size_t memoryBudget;
+        std::size_t lastMemoryUsage;
+
+        // loaded chunks split in four by the parity of their coordinates
+        std::array<std::vector<ChunkRef>, 4> chunkColours;
+        // writes a chunk made outside itself, one list per chunk of the colour ticking
+        std::vector<std::vector<TileWrite>> haloWrites;
+
+        // sparse set: entityIndex maps an id's index to its place in entities, plus one
+        std::vector<std::shared_ptr<Entity>> entities;
+        std::vector<uint32_t> entityIndex;
+        SpatialHash spatialIndex;
+        EntityStorage entityStorage;
+        std::vector<EntityId> removedEntities;
+        std::vector<EntityId> levelChanges;
+        // left for another level during tick(), picked up by the server between ticks
+        std::vector<EntityId> departures;
 
-        std::unordered_map<EntityId, std::shared_ptr<Entity>> entityMap;
+        [[nodiscard]] const std::shared_ptr<Entity>* findEntity(EntityId id) const;
+        void eraseEntity(EntityId id);
+
+        Chunk& install(ChunkLoad& load);
+        void track(const Vector2i& pos);
+
+        [[nodiscard]] std::optional<Tile> findTileAt(const Vector2i& pos) const;
+        void tickTiles(JobSystem* jobs);
+        void tickChunk(const ChunkRef& chunk, std::vector<TileWrite>& halo);
     public:
-        explicit World(const std::string& name);
+        World(WorldId id, const std::string& name);
+        ~World();
+
+        [[nodiscard]] WorldId getId() const;
+        [[nodiscard]] const std::string& getName() const;
+
+        /**
+         * Keeps the world in region files under directory, created if
+         * missing. Nothing is read yet, a chunk comes from its region file
+         * when first loaded: on io's threads through requestChunk(), or
+         * right away through getChunkAt().
+         */
+        void open(const std::string& directory, ChunkIO* io = nullptr);
+        [[nodiscard]] bool isOpen() const;
+
+        /**
+         * Makes the chunks the disk doesn't have, they are clean until
+         * changed since the generator makes them again the same.
+         */
+        void setGenerator(const WorldGenerator* generator);
+        [[nodiscard]] const WorldGenerator* getGenerator() const;
+
+        /**
+         * Loads every chunk from from up to to, excluded, reading or
+         * generating them in parallel on jobs. Returns how many were loaded.
+         * Throws std::runtime_error once done if some saved ones were
+         * damaged, those are left empty.
+         */
+        std::size_t pregenerate(const Vector2i& from, const Vector2i& to, JobSystem* jobs = nullptr);
+
+        /**
+         * True when the chunk at pos is loaded. Otherwise starts reading it
+         * in the background, if not done yet, and the tick after it is read
+         * puts it in the world. Until then the chunk is simply not there.
+         * Without a ChunkIO it is loaded right away.
+         */
+        bool requestChunk(const Vector2i& pos);
+        [[nodiscard]] bool isLoading(const Vector2i& pos) const;
+        [[nodiscard]] std::size_t getLoadingCount() const;
 
+        /**
+         * Puts the chunks read since the last call in the world, returns how
+         * many. Done at the end of every tick(). Throws std::runtime_error
+         * once all are in if some were damaged, those are left empty.
+         */
+        std::size_t installLoads();
+
+        /**
+         * Snapshots the dirty chunks and the items on the ground and hands
+         * them to the ChunkIO write thread, returns how many chunks. The
+         * chunks share their tiles with the snapshot instead of being
+         * copied or encoded here, and they are clean from now on: the tick
+         * is free to change them again, a change copies the tiles first.
+         */
+        std::size_t writeBack();
+        /**
+         * Puts back the items the last writeBack() saved, returns how many.
+         * Throws std::runtime_error if the file is damaged.
+         */
+        std::size_t loadEntities();
+
+        /**
+         * writeBack(), then waits until the writes are on disk.
+         */
+        std::size_t save();
+
+        /**
+         * Keeps the view window of radius chunks around center loaded until
+         * released, loading it is up to requestChunk(). Windows may overlap,
+         * a chunk is held as long as any window holds it.
+         */
+        void retainChunks(const Vector2i& center, int radius);
+        void releaseChunks(const Vector2i& center, int radius);
+
+        /**
+         * Bytes of chunks the world tries to stay under, 0 for no limit.
+         */
+        void setMemoryBudget(std::size_t bytes);
+        [[nodiscard]] std::size_t getMemoryBudget() const;
+
+        /**
+         * Over the budget, unloads the chunks no view holds, the least
+         * recently used first, until back under it. Dirty chunks are written
+         * back first, or kept when the world has nowhere to write them.
+         * Returns how many were unloaded. Done by tick() every
+         * EVICTION_TICKS ticks.
+         */
+        std::size_t evictChunks();
+        /**
+         * memoryUsage() as of the last eviction check.
+         */
+        [[nodiscard]] std::size_t getLastMemoryUsage() const;
+
+        /**
+         * The chunk at pos, loading it (from disk when the world is open,
+         * else from the generator) if it isn't yet. Waits for it if it is being read in the
+         * background. Throws std::runtime_error if the saved chunk is
+         * damaged, it stays loaded empty and the next save replaces it.
+         */
         Chunk& getChunkAt(const Vector2i& pos);
         [[nodiscard]] const Chunk& getChunkAt(const Vector2i& pos) const;
+
+        /**
+         * The tile at world tile coordinates, crossing chunk borders freely.
+         */
+        [[nodiscard]] Tile getTileAt(const Vector2i& pos) const;
+        void setTileAt(const Vector2i& pos, const Tile& tile);
+
+        [[nodiscard]] std::size_t memoryUsage() const;
+
+        template<typename F>
+        void forEachChunk(F&& function) {
+            loadedChunks.forEachChunk(std::forward<F>(function));
+        }
+
+        void addEntity(const std::shared_ptr<Entity>& entity);
+        bool removeEntity(EntityId id);
+        /**
+         * Null for unknown ids and for stale ones whose index was reused.
+         */
+        [[nodiscard]] std::shared_ptr<Entity> getEntity(EntityId id) const;
+
+        template<typename F>
+        void forEachEntity(F&& function) const {
+            for (const auto& entity : entities) {
+                function(entity);
+            }
+        }
+
+        [[nodiscard]] std::vector<std::shared_ptr<Entity>> getEntitiesIn(const Rectangle2f& area) const;
+        [[nodiscard]] std::vector<std::shared_ptr<Entity>> getEntitiesIn(const Circle2f& area) const;
+        [[nodiscard]] const SpatialHash& getSpatialIndex() const;
+        EntityStorage& getEntityStorage();
+
+        /**
+         * Runs the random tile ticks and the entity systems (arrow flight,
+         * item lifetime), then forgets the removed entities. Only touches
+         * this world, so worlds can tick on different threads, and splits
+         * the work over jobs when given, with the same result as without.
+         *
+         * Tile ticks go through the chunks in four phases, one per parity of
+         * the chunk coordinates, so no two neighbouring chunks tick at once.
+         * A tile may read its neighbours across the chunk border; what it
+         * writes there is applied once the phase is over.
+         */
+        void tick(JobSystem* jobs = nullptr);
+
+        /**
+         * Appends the entities now on another level, they are still in
+         * this world until the caller moves them.
+         */
+        void takeDepartures(std::vector<EntityId>& departed);
     };
 
 
@@ -0,0 +1,352 @@
+#include "WorldGenerator.h"
+
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MINICRAFT_AVX2_NOISE
+#include <immintrin.h>
+#endif
+
+using namespace mcplus;
+
+namespace {
+
+    constexpr int ROW_WIDTH = static_cast<int>(Chunk::CHUNK_WIDTH);
+
+    // every kind of noise of a level gets its own seed
+    enum Channel : std::uint32_t {
+        ELEVATION = 1,
+        MOISTURE,
+        FEATURES,
+        CAVES,
+        POOLS,
+        CLOUDS,
+        STAIRS
+    };
+
+    constexpr std::uint32_t HASH_X = 0x27D4EB2Du;
+    constexpr std::uint32_t HASH_Y = 0x165667B1u;
+
+    inline std::uint32_t hashOf(std::uint32_t seed, std::int32_t x, std::int32_t y) {
+        std::uint32_t hash = seed ^ static_cast<std::uint32_t>(x) * HASH_X ^ static_cast<std::uint32_t>(y) * HASH_Y;
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6Du;
+        hash ^= hash >> 12;
+        hash *= 0x297A2D39u;
+        hash ^= hash >> 15;
+        return hash;
+    }
+
+    // the top 24 bits, so the float holds them exactly
+    inline float latticeValue(std::uint32_t seed, std::int32_t x, std::int32_t y) {
+        return static_cast<float>(hashOf(seed, x, y) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /*
+     * Both kernels do the same float operations in the same order, and the
+     * file is built without FP contraction, so they agree to the last bit.
+     */
+
+    void valueNoiseScalar(std::uint32_t seed, float frequency, int x, int y, float* out) {
+        float fy = static_cast<float>(y) * frequency;
+        float y0 = std::floor(fy);
+        float ty = fy - y0;
+        float sy = ty * ty * (3.0f - 2.0f * ty);
+        auto iy  = static_cast<std::int32_t>(y0);
+
+        for (int i = 0; i < ROW_WIDTH; i++) {
+            float fx = static_cast<float>(x + i) * frequency;
+            float x0 = std::floor(fx);
+            float tx = fx - x0;
+            float sx = tx * tx * (3.0f - 2.0f * tx);
+            auto ix  = static_cast<std::int32_t>(x0);
+
+            float v00 = latticeValue(seed, ix, iy);
+            float v10 = latticeValue(seed, ix + 1, iy);
+            float v01 = latticeValue(seed, ix, iy + 1);
+            float v11 = latticeValue(seed, ix + 1, iy + 1);
+
+            float a = v00 + (v10 - v00) * sx;
+            float b = v01 + (v11 - v01) * sx;
+            out[i] = a + (b - a) * sy;
+        }
+    }
+
+#ifdef MINICRAFT_AVX2_NOISE
+    __attribute__((target("avx2")))
+    inline __m256 latticeValueAvx2(__m256i seed, __m256i x, std::int32_t y) {
+        __m256i hash = _mm256_xor_si256(_mm256_xor_si256(seed, _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(HASH_X)))),
+                                        _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(y) * HASH_Y)));
+        hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+        hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0x2C1B3C6D));
+        hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 12));
+        hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0x297A2D39));
+        hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(hash, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+    }
+
+    __attribute__((target("avx2")))
+    void valueNoiseAvx2(std::uint32_t seed, float frequency, int x, int y, float* out) {
+        float fy = static_cast<float>(y) * frequency;
+        float y0 = std::floor(fy);
+        float ty = fy - y0;
+        float sy = ty * ty * (3.0f - 2.0f * ty);
+        auto iy  = static_cast<std::int32_t>(y0);
+
+        const __m256i lanes  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i one    = _mm256_set1_epi32(1);
+        const __m256i seeds  = _mm256_set1_epi32(static_cast<int>(seed));
+        const __m256 three   = _mm256_set1_ps(3.0f);
+        const __m256 two     = _mm256_set1_ps(2.0f);
+        const __m256 factors = _mm256_set1_ps(frequency);
+        const __m256 sys     = _mm256_set1_ps(sy);
+
+        for (int i = 0; i < ROW_WIDTH; i += 8) {
+            __m256 fx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x + i), lanes)), factors);
+            __m256 x0 = _mm256_floor_ps(fx);
+            __m256 tx = _mm256_sub_ps(fx, x0);
+            __m256 sx = _mm256_mul_ps(_mm256_mul_ps(tx, tx), _mm256_sub_ps(three, _mm256_mul_ps(two, tx)));
+            __m256i ix  = _mm256_cvttps_epi32(x0);
+            __m256i ix1 = _mm256_add_epi32(ix, one);
+
+            __m256 v00 = latticeValueAvx2(seeds, ix, iy);
+            __m256 v10 = latticeValueAvx2(seeds, ix1, iy);
+            __m256 v01 = latticeValueAvx2(seeds, ix, iy + 1);
+            __m256 v11 = latticeValueAvx2(seeds, ix1, iy + 1);
+
+            __m256 a = _mm256_add_ps(v00, _mm256_mul_ps(_mm256_sub_ps(v10, v00), sx));
+            __m256 b = _mm256_add_ps(v01, _mm256_mul_ps(_mm256_sub_ps(v11, v01), sx));
+            _mm256_storeu_ps(out + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), sys)));
+        }
+    }
+#endif
+
+    inline bool chance(std::uint32_t hash, std::uint32_t oneIn) {
+        return hash % oneIn == 0;
+    }
+
+}
+
+WorldGenerator::WorldGenerator(WorldSeed seed) {
+    this->seed = seed;
+    this->avx2 = hasAvx2();
+}
+
+WorldSeed WorldGenerator::getSeed() const {
+    return seed;
+}
+
+bool WorldGenerator::hasAvx2() {
+#ifdef MINICRAFT_AVX2_NOISE
+    static const bool _avx2 = __builtin_cpu_supports("avx2");
+    return _avx2;
+#else
+    return false;
+#endif
+}
+
+bool WorldGenerator::usesAvx2() const {
+    return avx2;
+}
+
+void WorldGenerator::setAvx2(bool enabled) {
+    this->avx2 = enabled && hasAvx2();
+}
+
+std::uint32_t WorldGenerator::seedOf(WorldId level, std::uint32_t channel) const {
+    // splitmix64, so neighbouring levels and channels get unrelated seeds
+    std::uint64_t mixed = static_cast<std::uint64_t>(seed) ^ static_cast<std::uint64_t>(static_cast<std::uint32_t>(level)) << 32
+                          ^ channel * 0x9E3779B97F4A7C15ull;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<std::uint32_t>(mixed ^ (mixed >> 31));
+}
+
+void WorldGenerator::noiseRow(std::uint32_t channelSeed, int octaves, float frequency, int x, int y, float* out) const {
+    std::array<float, ROW_WIDTH> octave{};
+    float amplitude = 1.0f;
+    float total     = 0.0f;
+
+    for (int i = 0; i < ROW_WIDTH; i++) {
+        out[i] = 0.0f;
+    }
+    for (int index = 0; index < octaves; index++) {
+        std::uint32_t octaveSeed = channelSeed + static_cast<std::uint32_t>(index) * 0x9E3779B9u;
+#ifdef MINICRAFT_AVX2_NOISE
+        if (avx2) {
+            valueNoiseAvx2(octaveSeed, frequency, x, y, octave.data());
+        } else {
+            valueNoiseScalar(octaveSeed, frequency, x, y, octave.data());
+        }
+#else
+        valueNoiseScalar(octaveSeed, frequency, x, y, octave.data());
+#endif
+        for (int i = 0; i < ROW_WIDTH; i++) {
+            out[i] += octave[i] * amplitude;
+        }
+
+        total     += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    float scale = 1.0f / total;
+    for (int i = 0; i < ROW_WIDTH; i++) {
+        out[i] *= scale;
+    }
+}
+
+Vector2i WorldGenerator::stairsIn(WorldId upper, const Vector2i& cell) const {
+    // away from the cell border, so stairs of two cells are never side by side
+    constexpr auto span = static_cast<std::uint32_t>(STAIRS_CELL - 16);
+    std::uint32_t hash = hashOf(seedOf(upper, STAIRS), cell.x, cell.y);
+
+    return {cell.x * STAIRS_CELL + 8 + static_cast<int>(hash % span),
+            cell.y * STAIRS_CELL + 8 + static_cast<int>((hash >> 16) % span)};
+}
+
+void WorldGenerator::generateSurface(WorldId level, const Vector2i& origin, Tile* tiles) const {
+    std::array<float, Chunk::CHUNK_SIZE> elevation{};
+    std::array<float, Chunk::CHUNK_SIZE> moisture{};
+    for (int y = 0; y < ROW_WIDTH; y++) {
+        noiseRow(seedOf(level, ELEVATION), 4, 1.0f / 64, origin.x, origin.y + y, elevation.data() + y * ROW_WIDTH);
+        noiseRow(seedOf(level, MOISTURE), 2, 1.0f / 96, origin.x, origin.y + y, moisture.data() + y * ROW_WIDTH);
+    }
+
+    std::uint32_t features = seedOf(level, FEATURES);
+    for (int i = 0; i < static_cast<int>(Chunk::CHUNK_SIZE); i++) {
+        float height = elevation[i];
+        float wet    = moisture[i];
+        std::uint32_t hash = hashOf(features, origin.x + i % ROW_WIDTH, origin.y + i / ROW_WIDTH);
+
+        TileMaterial material;
+        if (height < 0.38f) {
+            material = TileMaterial::WATER;
+        } else if (height < 0.42f) {
+            material = TileMaterial::SAND;
+        } else if (height > 0.66f) {
+            material = TileMaterial::ROCK;
+        } else if (wet < 0.38f) {
+            material = chance(hash, 40) ? TileMaterial::CACTUS : TileMaterial::SAND;
+        } else if (wet > 0.6f) {
+            material = chance(hash, 3) ? TileMaterial::TREE : TileMaterial::GRASS;
+        } else if (chance(hash, 40)) {
+            material = TileMaterial::TREE;
+        } else {
+            material = chance(hash >> 8, 60) ? TileMaterial::FLOWER : TileMaterial::GRASS;
+        }
+        tiles[i] = Tile(static_cast<TileId>(material), 0);
+    }
+}
+
+void WorldGenerator::generateCaves(WorldId level, const Vector2i& origin, Tile* tiles) const {
+    static constexpr TileMaterial ORES[] = {TileMaterial::IRON_ORE, TileMaterial::GOLD_ORE, TileMaterial::GEM_ORE};
+    int depth = std::min(-level, 3);
+
+    std::array<float, Chunk::CHUNK_SIZE> caves{};
+    std::array<float, Chunk::CHUNK_SIZE> pools{};
+    for (int y = 0; y < ROW_WIDTH; y++) {
+        noiseRow(seedOf(level, CAVES), 3, 1.0f / 24, origin.x, origin.y + y, caves.data() + y * ROW_WIDTH);
+        noiseRow(seedOf(level, POOLS), 2, 1.0f / 32, origin.x, origin.y + y, pools.data() + y * ROW_WIDTH);
+    }
+
+    std::uint32_t features = seedOf(level, FEATURES);
+    for (int i = 0; i < static_cast<int>(Chunk::CHUNK_SIZE); i++) {
+        float cave = caves[i];
+        std::uint32_t hash = hashOf(features, origin.x + i % ROW_WIDTH, origin.y + i / ROW_WIDTH);
+
+        TileMaterial material;
+        // winding tunnels along the middle of the noise, and caverns where it peaks
+        if (std::abs(cave - 0.5f) < 0.05f || cave > 0.68f) {
+            material = pools[i] > 0.72f ? (depth == 3 ? TileMaterial::LAVA : TileMaterial::WATER) : TileMaterial::DIRT;
+        } else if (depth == 3 && cave < 0.3f) {
+            material = TileMaterial::HARD_ROCK;
+        } else if (chance(hash, 50)) {
+            material = ORES[depth - 1];
+        } else {
+            material = chance(hash >> 8, 300) ? TileMaterial::LAPIS_ORE : TileMaterial::ROCK;
+        }
+        tiles[i] = Tile(static_cast<TileId>(material), 0);
+    }
+}
+
+void WorldGenerator::generateSky(WorldId level, const Vector2i& origin, Tile* tiles) const {
+    std::array<float, Chunk::CHUNK_SIZE> clouds{};
+    for (int y = 0; y < ROW_WIDTH; y++) {
+        noiseRow(seedOf(level, CLOUDS), 3, 1.0f / 20, origin.x, origin.y + y, clouds.data() + y * ROW_WIDTH);
+    }
+
+    std::uint32_t features = seedOf(level, FEATURES);
+    for (int i = 0; i < static_cast<int>(Chunk::CHUNK_SIZE); i++) {
+        TileMaterial material = TileMaterial::INFINITE_FALL;
+        if (clouds[i] > 0.52f) {
+            std::uint32_t hash = hashOf(features, origin.x + i % ROW_WIDTH, origin.y + i / ROW_WIDTH);
+            material = chance(hash, 60) ? TileMaterial::CLOUD_CACTUS : TileMaterial::CLOUD;
+        }
+        tiles[i] = Tile(static_cast<TileId>(material), 0);
+    }
+}
+
+void WorldGenerator::generateDungeon(WorldId level, const Vector2i& origin, Tile* tiles) const {
+    std::array<float, Chunk::CHUNK_SIZE> pools{};
+    for (int y = 0; y < ROW_WIDTH; y++) {
+        noiseRow(seedOf(level, POOLS), 2, 1.0f / 16, origin.x, origin.y + y, pools.data() + y * ROW_WIDTH);
+    }
+
+    // a room per chunk, walled on its top and left side with a door in the middle of each
+    constexpr int door = ROW_WIDTH / 2;
+    for (int i = 0; i < static_cast<int>(Chunk::CHUNK_SIZE); i++) {
+        int x = i % ROW_WIDTH;
+        int y = i / ROW_WIDTH;
+        bool wall = (x == 0 && y != door && y != door - 1) || (y == 0 && x != door && x != door - 1);
+
+        TileMaterial material = TileMaterial::OBSIDIAN_FLOOR;
+        if (wall) {
+            material = TileMaterial::OBSIDIAN_WALL;
+        } else if (pools[i] > 0.7f && x > 1 && y > 1) {
+            material = TileMaterial::LAVA;
+        }
+        tiles[i] = Tile(static_cast<TileId>(material), 0);
+    }
+}
+
+void WorldGenerator::generate(WorldId level, const Vector2i& chunkPos, Chunk& chunk) const {
+    constexpr int width  = static_cast<int>(Chunk::CHUNK_WIDTH);
+    constexpr int height = static_cast<int>(Chunk::CHUNK_HEIGHT);
+
+    std::array<Tile, Chunk::CHUNK_SIZE> tiles{};
+    Vector2i origin{chunkPos.x * width, chunkPos.y * height};
+    if (level >= 1) {
+        generateSky(level, origin, tiles.data());
+    } else if (level == 0) {
+        generateSurface(level, origin, tiles.data());
+    } else if (level > -4) {
+        generateCaves(level, origin, tiles.data());
+    } else {
+        generateDungeon(level, origin, tiles.data());
+    }
+
+    // a chunk is always inside a single stairs cell
+    Vector2i cell{origin.x >= 0 ? origin.x / STAIRS_CELL : (origin.x + 1) / STAIRS_CELL - 1,
+                  origin.y >= 0 ? origin.y / STAIRS_CELL : (origin.y + 1) / STAIRS_CELL - 1};
+    auto placeStairs = [&](const Vector2i& stairs, TileMaterial material) {
+        int x = stairs.x - origin.x;
+        int y = stairs.y - origin.y;
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            tiles[x + y * width] = Tile(static_cast<TileId>(material), 0);
+        }
+    };
+    if (level > -4) {
+        placeStairs(stairsIn(level, cell), TileMaterial::STAIRS_DOWN);
+    }
+    if (level < 1) {
+        placeStairs(stairsIn(static_cast<WorldId>(level + 1), cell), TileMaterial::STAIRS_UP);
+    }
+
+    chunk.fill(tiles[0]);
+    for (int i = 1; i < static_cast<int>(Chunk::CHUNK_SIZE); i++) {
+        chunk.setTileAt({i % width, i / width}, tiles[i]);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef MINICRAFTSERVER_WORLDGENERATOR_H
+#define MINICRAFTSERVER_WORLDGENERATOR_H
+
+#include <cstdint>
+
+#include "MinicraftDef.h"
+#include "Dimension.h"
+#include "World.h"
+
+namespace mcplus {
+
+    /**
+     * Terrain of every level from a seed: grass, water, sand and forests on
+     * the surface, tunnels and ores in the caves, clouds in the sky and
+     * rooms in the dungeon, with stairs joining each level to the next.
+     *
+     * A chunk only depends on the seed, its level and its position, so
+     * chunks can be generated in any order on any thread and always come
+     * out the same. The noise runs eight tiles at a time with AVX2 when the
+     * CPU has it, and gives the same bits as the scalar code otherwise.
+     */
+    class WorldGenerator {
+    public:
+        // stairs join two levels once in every square of STAIRS_CELL x STAIRS_CELL tiles
+        static constexpr int STAIRS_CELL = 128;
+    private:
+        WorldSeed seed;
+        bool avx2;
+
+        [[nodiscard]] std::uint32_t seedOf(WorldId level, std::uint32_t channel) const;
+        /**
+         * Fractal value noise in [0, 1) for the CHUNK_WIDTH tiles of a chunk row.
+         */
+        void noiseRow(std::uint32_t channelSeed, int octaves, float frequency, int x, int y, float* out) const;
+        /**
+         * Where the stairs from upper down to the level under it are in a cell.
+         */
+        [[nodiscard]] Vector2i stairsIn(WorldId upper, const Vector2i& cell) const;
+
+        void generateSurface(WorldId level, const Vector2i& origin, Tile* tiles) const;
+        void generateCaves(WorldId level, const Vector2i& origin, Tile* tiles) const;
+        void generateSky(WorldId level, const Vector2i& origin, Tile* tiles) const;
+        void generateDungeon(WorldId level, const Vector2i& origin, Tile* tiles) const;
+    public:
+        explicit WorldGenerator(WorldSeed seed);
+
+        [[nodiscard]] WorldSeed getSeed() const;
+
+        /**
+         * Makes chunk the one at chunkPos of level.
+         */
+        void generate(WorldId level, const Vector2i& chunkPos, Chunk& chunk) const;
+
+        /**
+         * Whether this CPU runs the AVX2 kernels.
+         */
+        static bool hasAvx2();
+        [[nodiscard]] bool usesAvx2() const;
+        /**
+         * Forces the scalar kernels, or the AVX2 ones back where supported.
+         * The chunks are the same either way.
+         */
+        void setAvx2(bool enabled);
+    };
+
+}
+
+#endif // MINICRAFTSERVER_WORLDGENERATOR_H
@@ -6,9 +6,11 @@
 
 int main() {
     std::unique_ptr<mcplus::Server> server = std::make_unique<mcplus::Server>("127.0.0.1", 4225);
+    server->loadWorld("world");
 
     std::thread consoleReader{[&server]() {
-        while (!server->isShutdown()) {
+        // run() may not have started yet, so read before asking whether it stopped
+        do {
             std::string line{};
             std::getline(std::cin, line);
 
@@ -16,7 +18,7 @@ int main() {
             if (!server->dispatchCommand(line)) {
                 std::cout << "Command '" << line << "' doesn't exist" << std::endl;
             }
-        }
+        } while (!server->isShutdown());
     }};
 
     server->run();